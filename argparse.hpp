@@ -1,6 +1,7 @@
 #ifndef ARGPARSE_HPP_
 #define ARGPARSE_HPP_
 
+#include <string>
 #if __cplusplus >= 201103L
 #include <unordered_map>
 typedef std::unordered_map<std::string, size_t> IndexMap;
@@ -8,14 +9,49 @@ typedef std::unordered_map<std::string, size_t> IndexMap;
 #include <map>
 typedef std::map<std::string, size_t> IndexMap;
 #endif
-#include <string>
 #include <vector>
 #include <typeinfo>
+#include <stdint.h>
+#include <cstring>
+#include <cctype>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
 #include <cassert>
 #include <algorithm>
+#include <functional>
+#include <deque>
+#include <array>
+#include <tuple>
+#include <limits>
+#include <cstdlib>
+#include <type_traits>
+#include <chrono>
+#include <memory>
+#include <map>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/stat.h>
+#include <cerrno>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARGPARSE_SSE2
+#endif
+#if defined(_WIN32)
+#include <io.h>
+#include <fstream>
+#else
+#include <unistd.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 /*! @class ArgumentParser
  *  @brief A simple command-line argument parser based on the design of
@@ -88,6 +124,8 @@ private:
     }
     // OUTWARD CONVERSIONS
     template <typename ValueType>
+    bool holds() const { return content && content->type_info() == typeid(ValueType); }
+    template <typename ValueType>
     ValueType &castTo()
     {
       if (content->type_info() == typeid(ValueType))
@@ -108,9 +146,9 @@ private:
   private:
     template <typename ValueType>
     ValueType retrieve(identity<ValueType>) { throw std::bad_cast(); }
-    double retrieve(identity<double>) { return std::stod(static_cast<Holder<std::string> *>(content)->held_); }
-    int retrieve(identity<int>) { return std::stoi(static_cast<Holder<std::string> *>(content)->held_); }
-    bool retrieve(identity<bool>) { return static_cast<Holder<std::string> *>(content)->held_.compare("true") == 0; }
+    double retrieve(identity<double>) { return std::stod(castTo<std::string>()); }
+    int retrieve(identity<int>) { return std::stoi(castTo<std::string>()); }
+    bool retrieve(identity<bool>) { return castTo<std::string>().compare("true") == 0; }
 
   private:
     // Inner placeholder interface
@@ -163,11 +201,73 @@ private:
     return out;
   }
 
+  // the choices of an argument and a perfect hash of their names: hashed
+  // with seed, every name lands in a slot of its own, so a lookup costs one
+  // hash and one comparison
+  struct Choices
+  {
+    std::vector<std::string> names;
+    std::vector<long long> values;
+    // index in names of the name in each slot, or -1
+    std::vector<int> slots;
+    uint64_t seed;
+    static uint64_t hash(uint64_t seed, const char *data, size_t size)
+    {
+      uint64_t h = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+      for (size_t n = 0; n < size; ++n)
+        h = (h ^ (unsigned char)data[n]) * 1099511628211ULL;
+      return h ^ (h >> 29);
+    }
+    // search seeds until no two names share a slot, growing the table when
+    // a size has been tried long enough
+    void build()
+    {
+      size_t size = 4;
+      while (size < 2 * names.size())
+        size *= 2;
+      for (seed = 0;; ++seed)
+      {
+        if (seed > 0 && seed % 256 == 0)
+          size *= 2;
+        slots.assign(size, -1);
+        size_t n = 0;
+        for (; n < names.size(); ++n)
+        {
+          int &slot = slots[hash(seed, names[n].data(), names[n].size()) & (size - 1)];
+          if (slot >= 0)
+            break;
+          slot = n;
+        }
+        if (n == names.size())
+          return;
+      }
+    }
+    size_t find(const char *data, size_t size) const
+    {
+      int n = slots[hash(seed, data, size) & (slots.size() - 1)];
+      if (n < 0 || names[n].size() != size || names[n].compare(0, size, data, size) != 0)
+        return npos;
+      return n;
+    }
+    std::string list() const
+    {
+      std::string out;
+      for (size_t n = 0; n < names.size(); ++n)
+        out.append(n ? "," : "").append(names[n]);
+      return out;
+    }
+  };
+
+  struct Validator;
   struct Argument
   {
-    Argument() : short_name(""), name(""), required(false), default_value(""), help(""), fixed_nargs(0), fixed(true) {}
-    Argument(const std::string &_short_name, const std::string &_name, bool _required, char nargs, std::string _default = "", std::string _help = "")
-        : short_name(_short_name), name(_name), required(_required), default_value(_default), help(_help)
+    Argument() : short_name(""), name(""), required(false), default_value(""), help_ref(0), help_offset(0), help_size(0), path_checks(0), glob(0), delimiter(0), duplicates(0), store(0), reset(0), fixed_nargs(0), fixed(true) {}
+    Argument(const std::string &_short_name, const std::string &_name, bool _required, char nargs, std::string _default = "")
+        : short_name(_short_name), name(_name), required(_required), default_value(_default), help_ref(0), help_offset(0), help_size(0), path_checks(0), glob(0), delimiter(0), duplicates(0), store(0), reset(0)
+    {
+      setNargs(nargs);
+    }
+    void setNargs(char nargs)
     {
       if (nargs == '+' || nargs == '*')
       {
@@ -184,7 +284,28 @@ private:
     std::string name;
     bool required;
     std::string default_value;
-    std::string help;
+    // help borrowed from an ArgSpec, or 0 if it is in the help stream
+    const char *help_ref;
+    // location of the help text in the (uncompressed) help stream
+    size_t help_offset;
+    size_t help_size;
+    // PathCheck flags every input must satisfy
+    unsigned path_checks;
+    // GlobOption flags, non-zero if inputs are expanded as patterns
+    unsigned glob;
+    // separator of the items of each input of a list argument
+    char delimiter;
+    // DuplicatePolicy of a map argument
+    unsigned duplicates;
+    // typed storage: store converts an input into the slot in place of the
+    // default string storage, keeping a slot that holds several values to
+    // at most max_items, and reset empties the slot before each parse
+    bool (*store)(const Argument &arg, Any &slot, size_t index, const std::string &el, std::string &error, size_t max_items);
+    void (*reset)(Any &slot);
+    // the accepted inputs of an argument restricted to choices
+    std::shared_ptr<const Choices> choices;
+    // character class and pattern checks of every input
+    std::shared_ptr<const Validator> validator;
     union
     {
       size_t fixed_nargs;
@@ -196,6 +317,8 @@ private:
     {
       std::ostringstream s;
       std::string uname = name.empty() ? upper(strip(short_name)) : upper(strip(name));
+      if (choices)
+        uname = std::string("{").append(choices->list()).append("}");
       if (named && !required)
         s << "[";
       if (named)
@@ -224,10 +347,64 @@ private:
     }
   };
 
-  void insertArgument(const Argument &arg)
+  // --------------------------------------------------------------------------
+  // Parents
+  // --------------------------------------------------------------------------
+  // the arguments of parent parsers are referenced rather than copied. They
+  // take the first ids, in the order the parents were added, followed by the
+  // parser's own arguments
+  struct Parent
+  {
+    const ArgumentParser *parser;
+    size_t offset;
+  };
+  size_t argumentCount() const { return parent_size_ + arguments_.size(); }
+  const Argument &argumentAt(size_t N) const
+  {
+    if (N >= parent_size_)
+      return arguments_[N - parent_size_];
+    size_t n = parents_.size() - 1;
+    while (parents_[n].offset > N)
+      --n;
+    return parents_[n].parser->argumentAt(N - parents_[n].offset);
+  }
+  Argument &mutableArgument(size_t N)
+  {
+    if (N < parent_size_)
+      argumentError(std::string("cannot modify argument ").append(argumentAt(N).canonicalName()).append(" of a parent parser"));
+    return arguments_[N - parent_size_];
+  }
+  // id of the final argument, or npos if there is none
+  size_t finalId() const { return final_name_.empty() ? npos : lookup(final_name_); }
+  // id of the argument with the given name, searching the parents' frozen
+  // indexes after the parser's own
+  size_t lookup(const std::string &key) const
+  {
+    IndexMap::const_iterator it = index_.find(key);
+    if (it != index_.end())
+      return it->second;
+    for (size_t n = 0; n < parents_.size(); ++n)
+    {
+      size_t N = parents_[n].parser->lookup(key);
+      if (N != npos)
+        return parents_[n].offset + N;
+    }
+    return npos;
+  }
+
+  void insertArgument(const Argument &arg, const std::string &help = "")
   {
-    size_t N = arguments_.size();
     arguments_.push_back(arg);
+    indexArgument(help.data(), help.size());
+  }
+  // index the last argument of arguments_ and record its help
+  void indexArgument(const char *help, size_t help_size)
+  {
+    size_t N = argumentCount() - 1;
+    const Argument &arg = arguments_.back();
+    arguments_.back().help_offset = help_size_ + help_pending_.size();
+    arguments_.back().help_size = help_size;
+    help_pending_.append(help, help_size);
     if (arg.fixed && arg.fixed_nargs <= 1)
     {
       variables_.push_back(arg.default_value);
@@ -242,204 +419,3728 @@ private:
       index_[arg.name] = N;
     if (arg.required && arg.default_value.empty())
       required_++;
+    trie_dirty_ = true;
+    frozen_ = false;
+  }
+
+  size_t countAt(size_t N)
+  {
+    derive(N);
+    const Argument &arg = argumentAt(N);
+    Any &var = variables_[N];
+    // typed inputs are converted as they are stored, so only presence is known
+    if (arg.store)
+      return testBit(seen_, N) || !arg.default_value.empty();
+    // check if the argument is a vector
+    if (!arg.fixed || arg.fixed_nargs > 1)
+      return var.castTo<std::vector<std::string>>().size();
+    else if (arg.fixed_nargs > 0)
+      return !var.castTo<std::string>().empty();
+    else
+      return 1;
+  }
+  template <typename T>
+  const T retrieveAt(size_t N)
+  {
+    if (countAt(N) == 0)
+      throw std::out_of_range("Value not found");
+    Any &var = variables_[N];
+    if (var.holds<T>())
+      return var.castTo<T>();
+    // conversions of the stored strings are memoized until the slot is next
+    // written, keeping the type last asked for
+    if (testBit(cached_, N) && cache_[N].holds<T>())
+      return cache_[N].castTo<T>();
+    T value = var.retrieve<T>();
+    if (cache_.size() <= N)
+      cache_.resize(argumentCount());
+    cache_[N] = value;
+    setBit(cached_, N);
+    return value;
+  }
+  // restore every input to its default before a new parse
+  void resetInputs(size_t from = 0)
+  {
+    for (size_t N = from; N < argumentCount(); ++N)
+    {
+      const Argument &arg = argumentAt(N);
+      clearBit(cached_, N);
+      if (arg.reset)
+      {
+        arg.reset(variables_[N]);
+        if (arg.fixed && arg.fixed_nargs == 1)
+        {
+          if (!arg.default_value.empty())
+            storeTyped(N, 0, arg.default_value);
+          continue;
+        }
+        // the default of a typed argument with several inputs lists them
+        // separated by spaces
+        std::istringstream defaults(arg.default_value);
+        std::string el;
+        for (size_t index = 0; defaults >> el; ++index)
+          storeTyped(N, index, el);
+      }
+      else if (arg.fixed && arg.fixed_nargs <= 1)
+        variables_[N].castTo<std::string>() = arg.default_value;
+      else
+        variables_[N].castTo<std::vector<std::string>>().clear();
+    }
+  }
+  void storeTyped(size_t N, size_t index, const std::string &el)
+  {
+    std::string error;
+    size_t max_items = limits_.max_values ? limits_.max_values : size_t(npos);
+    if (!argumentAt(N).store(argumentAt(N), variables_[N], index, el, error, max_items))
+      argumentError(std::string("invalid input ").append(el).append(" to ").append(argumentAt(N).canonicalName()).append(": ").append(error), true);
+  }
+  void storeInput(size_t N, const std::string &el)
+  {
+    if (argumentAt(N).glob && hasWildcard(el))
+      expandGlob(N, el);
+    else
+      deliverInput(N, el);
+  }
+  void deliverInput(size_t N, const std::string &el)
+  {
+    const Argument &arg = argumentAt(N);
+    // index of the input among those given to the argument
+    size_t index = arg.fixed && arg.fixed_nargs == 1 ? 0 : delivered_[N]++;
+    // a map counts its keys instead, since repeating a key adds none
+    if (limits_.max_values && index >= limits_.max_values && arg.store != storeMap)
+      argumentError(limitError(std::string("too many inputs to ").append(arg.canonicalName()), limits_.max_values));
+    clearBit(cached_, N);
+    std::string error;
+    if (arg.validator && !arg.validator->check(el, error))
+      argumentError(std::string("invalid input ").append(el).append(" to ").append(arg.canonicalName()).append(": ").append(error), true);
+    if (N < sinks_.size() && sinks_[N])
+      sinks_[N](el);
+    else if (arg.store)
+      storeTyped(N, index, el);
+    else if (arg.fixed && arg.fixed_nargs == 1)
+      variables_[N].castTo<std::string>() = el;
+    else
+      variables_[N].castTo<std::vector<std::string>>().push_back(el);
+    if (arg.path_checks)
+      queuePath(N, index, el);
   }
 
   // --------------------------------------------------------------------------
-  // Error handling
+  // Name trie
   // --------------------------------------------------------------------------
-  void argumentError(const std::string &msg, bool show_usage = false)
+  static const size_t npos = static_cast<size_t>(-1);
+  // one node per dotted segment of a long name. The arguments below a node
+  // occupy the contiguous range [begin, end) of ns_order_, so a subtree is
+  // enumerated without walking its interior nodes
+  struct TrieNode
   {
-    if (use_exceptions_)
-      throw std::invalid_argument(msg);
-    std::cerr << "ArgumentParser error: " << msg << std::endl;
-    if (show_usage)
-      std::cerr << usage() << std::endl;
-    exit(-5);
+    TrieNode(const std::string &_segment, size_t _prefix_size)
+        : segment(_segment), prefix_size(_prefix_size), argument(npos), begin(0), end(0) {}
+    std::string segment;
+    size_t prefix_size;
+    size_t argument;
+    size_t begin;
+    size_t end;
+    std::vector<size_t> children;
+  };
+  struct SegmentOrder
+  {
+    const std::vector<TrieNode> *trie;
+    bool operator()(size_t a, size_t b) const { return (*trie)[a].segment < (*trie)[b].segment; }
+  };
+
+  void buildTrie()
+  {
+    if (!trie_dirty_)
+      return;
+    trie_.assign(1, TrieNode("", 2));
+    ns_order_.clear();
+    IndexMap nodes;
+    for (size_t N = 0; N < argumentCount(); ++N)
+    {
+      const std::string &name = argumentAt(N).name;
+      if (name.empty())
+        continue;
+      size_t node = 0;
+      for (size_t b = 2, e; b <= name.size(); b = e + 1)
+      {
+        e = std::min(name.find('.', b), name.size());
+        std::pair<IndexMap::iterator, bool> it = nodes.insert(std::make_pair(name.substr(0, e), trie_.size()));
+        if (it.second)
+        {
+          trie_.push_back(TrieNode(name.substr(b, e - b), e + 1));
+          trie_[node].children.push_back(it.first->second);
+        }
+        node = it.first->second;
+      }
+      trie_[node].argument = N;
+    }
+    SegmentOrder order = {&trie_};
+    for (size_t node = 0; node < trie_.size(); ++node)
+      std::sort(trie_[node].children.begin(), trie_[node].children.end(), order);
+    numberTrie(0);
+    trie_dirty_ = false;
+  }
+  void numberTrie(size_t node)
+  {
+    trie_[node].begin = ns_order_.size();
+    if (trie_[node].argument != npos)
+      ns_order_.push_back(trie_[node].argument);
+    for (size_t c = 0; c < trie_[node].children.size(); ++c)
+      numberTrie(trie_[node].children[c]);
+    trie_[node].end = ns_order_.size();
+  }
+  // resolve a dotted name relative to node, one segment at a time
+  size_t findNode(size_t node, const std::string &name) const
+  {
+    size_t b = name.find_first_not_of('-');
+    for (size_t e; node != npos && b < name.size(); b = e + 1)
+    {
+      e = std::min(name.find('.', b), name.size());
+      if (e == b)
+        continue;
+      const std::vector<size_t> &children = trie_[node].children;
+      size_t lo = 0, hi = children.size();
+      while (lo < hi)
+      {
+        size_t mid = (lo + hi) / 2;
+        if (trie_[children[mid]].segment.compare(0, std::string::npos, name, b, e - b) < 0)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if (lo < children.size() && trie_[children[lo]].segment.compare(0, std::string::npos, name, b, e - b) == 0)
+        node = children[lo];
+      else
+        node = npos;
+    }
+    return node;
   }
 
   // --------------------------------------------------------------------------
-  // Member variables
+  // Constraints
   // --------------------------------------------------------------------------
-  IndexMap index_;
-  bool ignore_first_;
-  bool use_exceptions_;
-  size_t required_;
-  std::string app_name_;
-  std::string final_name_;
-  std::vector<Argument> arguments_;
-  std::vector<Any> variables_;
+  typedef std::vector<uint64_t> Bitset;
+  static void setBit(Bitset &bits, size_t n)
+  {
+    if (bits.size() <= n / 64)
+      bits.resize(n / 64 + 1, 0);
+    bits[n / 64] |= (uint64_t)1 << (n % 64);
+  }
+  static void clearBit(Bitset &bits, size_t n)
+  {
+    if (n / 64 < bits.size())
+      bits[n / 64] &= ~((uint64_t)1 << (n % 64));
+  }
+  static bool testBit(const Bitset &bits, size_t n) { return n / 64 < bits.size() && (bits[n / 64] >> (n % 64)) & 1; }
+  static size_t popcount(uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    size_t n = 0;
+    for (; word; word &= word - 1)
+      n++;
+    return n;
+#endif
+  }
+
+  // constraints are compiled into masks over argument ids, and checked
+  // against the set of arguments seen once parsing has finished
+  struct Constraint
+  {
+    enum Kind
+    {
+      EXCLUSIVE,
+      REQUIRES,
+      CONFLICTS
+    };
+    Kind kind;
+    bool required;
+    size_t subject;
+    Bitset mask;
+  };
+
+  size_t argumentId(const std::string &name)
+  {
+    size_t N = lookup(delimit(name));
+    if (N == npos)
+      argumentError(std::string("unknown argument '").append(name).append("'"));
+    return N;
+  }
+  std::string maskNames(const Bitset &mask, bool seen_only) const
+  {
+    std::string out;
+    for (size_t N = 0; N < argumentCount(); ++N)
+      if (testBit(mask, N) && (!seen_only || testBit(seen_, N)))
+        out.append(out.empty() ? "" : ", ").append(argumentAt(N).canonicalName());
+    return out;
+  }
+  void checkConstraints()
+  {
+    std::string violations;
+    for (std::vector<Constraint>::const_iterator it = constraints_.begin(); it != constraints_.end(); ++it)
+    {
+      const Constraint &c = *it;
+      size_t nseen = 0;
+      bool all = true;
+      for (size_t w = 0; w < c.mask.size(); ++w)
+      {
+        uint64_t hit = c.mask[w] & (w < seen_.size() ? seen_[w] : 0);
+        nseen += popcount(hit);
+        all = all && hit == c.mask[w];
+      }
+      std::string msg;
+      if (c.kind == Constraint::EXCLUSIVE && nseen > 1)
+        msg = std::string("arguments ").append(maskNames(c.mask, true)).append(" are mutually exclusive");
+      else if (c.kind == Constraint::EXCLUSIVE && nseen == 0 && c.required)
+        msg = std::string("one of the arguments ").append(maskNames(c.mask, false)).append(" is required");
+      else if (c.kind == Constraint::REQUIRES && testBit(seen_, c.subject) && !all)
+        msg = std::string("argument ").append(argumentAt(c.subject).canonicalName()).append(" requires ").append(maskNames(c.mask, false));
+      else if (c.kind == Constraint::CONFLICTS && testBit(seen_, c.subject) && nseen > 0)
+        msg = std::string("argument ").append(argumentAt(c.subject).canonicalName()).append(" conflicts with ").append(maskNames(c.mask, true));
+      if (!msg.empty())
+        violations.append(violations.empty() ? "" : "; ").append(msg);
+    }
+    if (!violations.empty())
+      argumentError(violations, true);
+  }
 
-public:
-  ArgumentParser() : ignore_first_(true), use_exceptions_(false), required_(0) {}
   // --------------------------------------------------------------------------
-  // addArgument
+  // Derived defaults
   // --------------------------------------------------------------------------
-  void appName(const std::string &name) { app_name_ = name; }
-  void addArgument(const std::string &name, char nargs = 0,
-                   std::string _default = "", bool required = false, std::string help = "")
+  struct Derived
   {
-    if (name.size() > 2)
+    std::vector<size_t> depends;
+    std::function<std::string(ArgumentParser &)> fn;
+  };
+
+  // compute the default of an argument that was not given on the command
+  // line from its dependencies, the first time it is asked for
+  void derive(size_t N)
+  {
+    if (N >= derived_of_.size() || derived_of_[N] == npos || testBit(seen_, N) || testBit(derived_done_, N))
+      return;
+    if (testBit(derived_busy_, N))
+      argumentError(std::string("cyclic derived default for ").append(argumentAt(N).canonicalName()));
+    setBit(derived_busy_, N);
+    const Derived &d = derived_[derived_of_[N]];
+    std::string value;
+    try
     {
-      Argument arg("", verify(name), required, nargs);
-      insertArgument(arg);
+      for (size_t n = 0; n < d.depends.size(); ++n)
+        derive(d.depends[n]);
+      value = d.fn(*this);
     }
-    else
+    catch (...)
     {
-      Argument arg(verify(name), "", required, nargs);
-      insertArgument(arg);
+      // a failed derivation is not a cycle, and may be retried
+      clearBit(derived_busy_, N);
+      throw;
     }
+    variables_[N].castTo<std::string>() = value;
+    clearBit(cached_, N);
+    clearBit(derived_busy_, N);
+    setBit(derived_done_, N);
   }
-  void addArgument(const std::string &short_name, const std::string &name, char nargs = 0,
-                   std::string _default = "", bool required = false, std::string help = "")
+  // depth-first search for a cycle through the declared dependencies. On
+  // success path holds the cycle, starting and ending at the same argument
+  bool findCycle(size_t N, std::vector<char> &state, std::vector<size_t> &path) const
   {
-    Argument arg(verify(short_name), verify(name), required, nargs, _default, help);
-    insertArgument(arg);
+    if (state[N] == 2)
+      return false;
+    path.push_back(N);
+    if (state[N] == 1)
+      return true;
+    state[N] = 1;
+    if (derived_of_[N] != npos)
+    {
+      const std::vector<size_t> &depends = derived_[derived_of_[N]].depends;
+      for (size_t n = 0; n < depends.size(); ++n)
+        if (findCycle(depends[n], state, path))
+          return true;
+    }
+    state[N] = 2;
+    path.pop_back();
+    return false;
   }
-  void addFinalArgument(const std::string &name, char nargs = 1, std::string _default = "", bool required = true, std::string help = "")
+
+  // --------------------------------------------------------------------------
+  // Help text
+  // --------------------------------------------------------------------------
+  // help text is rarely shown, so it is packed into a byte-oriented LZ77
+  // stream when the schema is frozen and only expanded by help(). Each
+  // sequence is a token (literal count << 4 | match length - 4), the
+  // literals, and a little-endian 16-bit match offset. Counts of 15 continue
+  // in the following bytes. The last sequence of a chunk has no match
+  struct HelpChunk
   {
-    final_name_ = delimit(name);
-    Argument arg("", final_name_, required, nargs);
-    insertArgument(arg);
+    size_t packed_offset;
+    size_t raw_size;
+  };
+  static void packLength(std::string &out, size_t n)
+  {
+    for (; n >= 255; n -= 255)
+      out += (char)255;
+    out += (char)n;
   }
-  void ignoreFirstArgument(bool ignore_first) { ignore_first_ = ignore_first; }
-  std::string verify(const std::string &name)
+  static size_t unpackLength(const std::string &in, size_t &pos, size_t n)
   {
-    if (name.empty())
-      argumentError("argument names must be non-empty");
-    if ((name.size() == 2 && name[0] != '-') || name.size() == 3)
-      argumentError(std::string("invalid argument '")
-                        .append(name)
-                        .append("'. Short names must begin with '-'"));
-    if (name.size() > 3 && (name[0] != '-' || name[1] != '-'))
-      argumentError(std::string("invalid argument '")
-                        .append(name)
-                        .append("'. Multi-character names must begin with '--'"));
-    return name;
+    if (n == 15)
+    {
+      unsigned char c;
+      do
+      {
+        c = in[pos++];
+        n += c;
+      } while (c == 255);
+    }
+    return n;
+  }
+  static void packSequence(std::string &out, const std::string &in, size_t anchor, size_t literals, size_t offset, size_t length)
+  {
+    size_t extra = length ? length - 4 : 0;
+    out += (char)((std::min(literals, (size_t)15) << 4) | std::min(extra, (size_t)15));
+    if (literals >= 15)
+      packLength(out, literals - 15);
+    out.append(in, anchor, literals);
+    if (length == 0)
+      return;
+    out += (char)(offset & 0xff);
+    out += (char)(offset >> 8);
+    if (extra >= 15)
+      packLength(out, extra - 15);
+  }
+  static void compress(const std::string &in, std::string &out)
+  {
+    const size_t hash_bits = 12;
+    std::vector<size_t> table((size_t)1 << hash_bits, size_t(npos));
+    size_t anchor = 0, pos = 0;
+    while (pos + 4 <= in.size())
+    {
+      uint32_t seq;
+      memcpy(&seq, in.data() + pos, 4);
+      size_t h = (uint32_t)(seq * 2654435761u) >> (32 - hash_bits);
+      size_t candidate = table[h];
+      table[h] = pos;
+      if (candidate == npos || pos - candidate > 65535 || memcmp(in.data() + candidate, in.data() + pos, 4) != 0)
+      {
+        pos++;
+        continue;
+      }
+      size_t length = 4;
+      while (pos + length < in.size() && in[candidate + length] == in[pos + length])
+        length++;
+      packSequence(out, in, anchor, pos - anchor, pos - candidate, length);
+      pos += length;
+      anchor = pos;
+    }
+    if (anchor < in.size())
+      packSequence(out, in, anchor, in.size() - anchor, 0, 0);
+  }
+  static void decompress(const std::string &in, size_t pos, size_t raw_size, std::string &out)
+  {
+    const size_t end = out.size() + raw_size;
+    while (out.size() < end)
+    {
+      unsigned char token = in[pos++];
+      size_t literals = unpackLength(in, pos, token >> 4);
+      out.append(in, pos, literals);
+      pos += literals;
+      if (out.size() >= end)
+        break;
+      size_t offset = (unsigned char)in[pos] | ((size_t)(unsigned char)in[pos + 1] << 8);
+      pos += 2;
+      size_t length = unpackLength(in, pos, token & 15) + 4;
+      // matches may overlap the bytes they produce
+      for (size_t from = out.size() - offset; length > 0; --length)
+        out += out[from++];
+    }
+  }
+  void packHelp()
+  {
+    if (help_pending_.empty())
+      return;
+    HelpChunk chunk = {help_packed_.size(), help_pending_.size()};
+    compress(help_pending_, help_packed_);
+    help_chunks_.push_back(chunk);
+    help_size_ += help_pending_.size();
+    std::string().swap(help_pending_);
+  }
+  // the help of every argument, by id, including those of the parents
+  void collectHelp(std::vector<std::string> &out) const
+  {
+    for (size_t n = 0; n < parents_.size(); ++n)
+      parents_[n].parser->collectHelp(out);
+    std::string text = helpText();
+    for (size_t n = 0; n < arguments_.size(); ++n)
+    {
+      const Argument &arg = arguments_[n];
+      out.push_back(arg.help_ref ? std::string(arg.help_ref) : text.substr(arg.help_offset, arg.help_size));
+    }
+  }
+  std::string helpText() const
+  {
+    std::string text;
+    text.reserve(help_size_ + help_pending_.size());
+    for (size_t n = 0; n < help_chunks_.size(); ++n)
+      decompress(help_packed_, help_chunks_[n].packed_offset, help_chunks_[n].raw_size, text);
+    return text.append(help_pending_);
   }
 
   // --------------------------------------------------------------------------
-  // Parse
+  // Path validation
   // --------------------------------------------------------------------------
-  void parse(size_t argc, const char **argv) { parse(std::vector<std::string>(argv, argv + argc)); }
+  // inputs of path arguments are stat'ed in batches on worker threads while
+  // parsing continues. Results are merged into path_status_ at the end of
+  // parse(), and the last partial batch runs on the calling thread
+  struct PathJob
+  {
+    size_t argument;
+    size_t index;
+    std::string path;
+    unsigned status;
+  };
+  typedef std::vector<PathJob> PathBatch;
+  static const size_t path_batch_size = 256;
 
-  void parse(const std::vector<std::string> &argv)
+  static PathBatch statPaths(PathBatch batch)
+  {
+    for (PathBatch::iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+#if defined(_WIN32)
+      struct _stat st;
+      bool found = _stat(it->path.c_str(), &st) == 0;
+      bool readable = found && _access(it->path.c_str(), 4) == 0;
+#else
+      struct stat st;
+      bool found = stat(it->path.c_str(), &st) == 0;
+      bool readable = found && access(it->path.c_str(), R_OK) == 0;
+#endif
+      it->status = 0;
+      if (found)
+        it->status |= PATH_EXISTS | ((st.st_mode & S_IFMT) == S_IFDIR ? PATH_IS_DIR : 0) |
+                      ((st.st_mode & S_IFMT) == S_IFREG ? PATH_IS_FILE : 0);
+      if (readable)
+        it->status |= PATH_READABLE;
+    }
+    return batch;
+  }
+  void queuePath(size_t N, size_t index, const std::string &path)
   {
-    // check if the app is named
-    if (app_name_.empty() && ignore_first_ && !argv.empty())
+    PathJob job = {N, index, path, 0};
+    path_batch_.push_back(job);
+    if (path_batch_.size() < path_batch_size)
+      return;
+    // bound the number of batches in flight to the number of cores
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    if (path_inflight_.size() >= workers)
     {
-      app_name_ = argv[0];
-      app_name_ = app_name_.substr(app_name_.find_last_of("\\/") + 1, app_name_.length());
+      mergePaths(path_inflight_.front().get());
+      path_inflight_.pop_front();
     }
+    PathBatch batch;
+    batch.swap(path_batch_);
+    path_inflight_.push_back(std::async(std::launch::async, statPaths, std::move(batch)));
+  }
+  void mergePaths(const PathBatch &batch)
+  {
+    for (PathBatch::const_iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+      std::vector<unsigned> &status = path_status_[it->argument];
+      if (status.size() <= it->index)
+        status.resize(it->index + 1, 0);
+      status[it->index] = it->status;
 
-    // set up the working set
-    Argument active;
-    Argument final = final_name_.empty() ? Argument() : arguments_[index_[final_name_]];
-    size_t consumed = 0;
-    size_t nrequired = !final.required ? required_ : required_ - 1;
-    size_t nfinal = !final.required ? 0 : (final.fixed ? final.fixed_nargs : (final.variable_nargs == '+' ? 1 : 0));
+      unsigned missing = argumentAt(it->argument).path_checks & ~it->status;
+      if (!missing)
+        continue;
+      std::string msg = std::string("path ").append(it->path).append(" passed to ").append(argumentAt(it->argument).canonicalName());
+      if (missing & PATH_EXISTS)
+        msg.append(" does not exist");
+      else if (missing & PATH_READABLE)
+        msg.append(" is not readable");
+      else if (missing & PATH_IS_DIR)
+        msg.append(" is not a directory");
+      else
+        msg.append(" is not a regular file");
+      path_violations_.append(path_violations_.empty() ? "" : "; ").append(msg);
+    }
+  }
+  void validatePaths()
+  {
+    mergePaths(statPaths(path_batch_));
+    path_batch_.clear();
+    for (; !path_inflight_.empty(); path_inflight_.pop_front())
+      mergePaths(path_inflight_.front().get());
+    if (!path_violations_.empty())
+      argumentError(path_violations_, true);
+  }
 
-    // iterate over each element of the array
-    for (std::vector<std::string>::const_iterator in = argv.begin() + ignore_first_;
-         in < argv.end() - nfinal; ++in)
-    {
-      std::string active_name = active.canonicalName();
-      std::string el = *in;
+  // --------------------------------------------------------------------------
+  // Glob expansion
+  // --------------------------------------------------------------------------
+  static bool hasWildcard(const std::string &el) { return el.find_first_of("*?[") != std::string::npos; }
+  static std::string joinPath(const std::string &dir, const std::string &name)
+  {
+    if (dir.empty())
+      return name;
+    return dir[dir.size() - 1] == '/' ? dir + name : dir + "/" + name;
+  }
 
-      //  check if the element is a key
-      if (index_.count(el) == 0)
+  /*! @class GlobWalker
+   *  @brief Expands one pattern by walking directories on a pool of threads.
+   *
+   *  Work items are (directory, segment) pairs: the directory matches the
+   *  first segments of the pattern, and its entries are matched against the
+   *  next one. A "**" segment matches any number of directories. Matches are
+   *  handed back to the calling thread as they are found.
+   */
+  class GlobWalker
+  {
+  public:
+    GlobWalker(const std::string &pattern) : busy_(0), cancelled_(false)
+    {
+      for (size_t b = 0, e; b <= pattern.size(); b = e + 1)
+      {
+        e = std::min(pattern.find('/', b), pattern.size());
+        if (e > b)
+          segments_.push_back(pattern.substr(b, e - b));
+      }
+      Item root = {pattern.size() && pattern[0] == '/' ? "/" : "", 0};
+      queue_.push_back(root);
+    }
+    void run(std::function<void(const std::string &)> emit)
+    {
+#if !defined(_WIN32)
+      std::vector<std::thread> workers(std::max(1u, std::thread::hardware_concurrency()));
+      for (size_t n = 0; n < workers.size(); ++n)
+        workers[n] = std::thread(&GlobWalker::work, this);
+      std::vector<std::string> matches;
+      try
       {
-        // input
-        // is the current active argument expecting more inputs?
-        if (active.fixed && active.fixed_nargs <= consumed)
-          argumentError(std::string("attempt to pass too many inputs to ").append(active_name),
-                        true);
-        if (active.fixed && active.fixed_nargs == 1)
+        for (bool done = false; !done;)
         {
-          variables_[index_[active_name]].castTo<std::string>() = el;
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (matches_.empty() && !(queue_.empty() && busy_ == 0))
+              ready_.wait(lock);
+            matches.swap(matches_);
+            done = queue_.empty() && busy_ == 0;
+          }
+          for (size_t n = 0; n < matches.size(); ++n)
+            emit(matches[n]);
+          matches.clear();
         }
-        else
+      }
+      catch (...)
+      {
+        // emit failed: stop the workers before the error leaves the walk
         {
-          variables_[index_[active_name]].castTo<std::vector<std::string>>().push_back(el);
+          std::lock_guard<std::mutex> lock(mutex_);
+          cancelled_ = true;
+          queue_.clear();
         }
-        consumed++;
+        ready_.notify_all();
+        for (size_t n = 0; n < workers.size(); ++n)
+          workers[n].join();
+        throw;
       }
-      else
+      for (size_t n = 0; n < workers.size(); ++n)
+        workers[n].join();
+#endif
+    }
+
+  private:
+    struct Item
+    {
+      std::string dir;
+      size_t segment;
+    };
+#if !defined(_WIN32)
+    void work()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (;;)
       {
-        // new key!
-        // has the active argument consumed enough elements?
-        if ((active.fixed && active.fixed_nargs != consumed) ||
-            (!active.fixed && active.variable_nargs == '+' && consumed < 1))
-          argumentError(std::string("encountered argument ")
-                            .append(el)
-                            .append(" when expecting more inputs to ")
-                            .append(active_name),
-                        true);
-
-        active = arguments_[index_[el]];
-        // if nargs == 0(store_ture, that means no more argument)
-        if (active.fixed && active.fixed_nargs == 0)
-          variables_[index_[active.canonicalName()]].castTo<std::string>() = "true";
-
-        // check if we've satisfied the required arguments
-        if (!active.required && nrequired > 0)
-          argumentError(std::string("encountered required argument ")
-                            .append(el)
-                            .append(" when expecting more required arguments"),
-                        true);
-        // are there enough arguments for the new argument to consume?
-        if ((active.fixed && active.fixed_nargs > (argv.end() - in - nfinal - 1)) ||
-            (!active.fixed && active.variable_nargs == '+' &&
-             !(argv.end() - in - nfinal - 1)))
-          argumentError(std::string("too few inputs passed to argument ").append(el), true);
-        if (active.required && active.default_value.empty())
-          nrequired--;
-        consumed = 0;
-      }
-    }
-
-    for (std::vector<std::string>::const_iterator in =
-             std::max(argv.begin() + ignore_first_, argv.end() - nfinal);
-         in != argv.end(); ++in)
-    {
-      std::string el = *in;
-      // check if we accidentally find an argument specifier
-      if (index_.count(el))
-        argumentError(std::string("encountered argument specifier ")
-                          .append(el)
-                          .append(" while parsing final required inputs"),
-                      true);
-      if (final.fixed && final.fixed_nargs == 1)
+        while (queue_.empty() && busy_ > 0 && !cancelled_)
+          ready_.wait(lock);
+        if (queue_.empty() || cancelled_)
+          break;
+        Item item = queue_.front();
+        queue_.pop_front();
+        busy_++;
+        lock.unlock();
+        std::vector<Item> items;
+        std::vector<std::string> matches;
+        expand(item, items, matches);
+        lock.lock();
+        busy_--;
+        ready_.notify_all();
+        if (cancelled_)
+          break;
+        queue_.insert(queue_.end(), items.begin(), items.end());
+        matches_.insert(matches_.end(), matches.begin(), matches.end());
+      }
+      ready_.notify_all();
+    }
+    void expand(const Item &item, std::vector<Item> &items, std::vector<std::string> &matches)
+    {
+      if (item.segment == segments_.size())
       {
-        variables_[index_[final_name_]].castTo<std::string>() = el;
+        // a leading "**" also reaches the current directory, which is not
+        // a match
+        if (!item.dir.empty())
+          matches.push_back(item.dir);
+        return;
       }
-      else
+      const std::string &segment = segments_[item.segment];
+      bool last = item.segment + 1 == segments_.size();
+      // literal segments need a stat rather than a directory listing
+      if (!hasWildcard(segment))
+      {
+        std::string path = joinPath(item.dir, segment);
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+          return;
+        if (last)
+          matches.push_back(path);
+        else if (S_ISDIR(st.st_mode))
+          items.push_back(Item{path, item.segment + 1});
+        return;
+      }
+      bool recursive = segment == "**";
+      if (recursive)
+        items.push_back(Item{item.dir, item.segment + 1});
+      DIR *dir = opendir(item.dir.empty() ? "." : item.dir.c_str());
+      if (!dir)
+        return;
+      while (struct dirent *entry = readdir(dir))
       {
-        variables_[index_[final_name_]].castTo<std::vector<std::string>>().push_back(el);
+        const char *name = entry->d_name;
+        // like the shell, wildcards do not match hidden entries, and never
+        // match . or ..
+        if (name[0] == '.' && (recursive || segment[0] != '.' || name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+          continue;
+        if (!recursive && fnmatch(segment.c_str(), name, 0) != 0)
+          continue;
+        std::string path = joinPath(item.dir, name);
+        bool is_dir = entry->d_type == DT_DIR;
+        // like bash globstar, "**" does not follow symbolic links, which
+        // could otherwise lead it around a cycle
+        if (entry->d_type == DT_UNKNOWN || (entry->d_type == DT_LNK && !recursive))
+        {
+          struct stat st;
+          is_dir = (recursive ? lstat(path.c_str(), &st) : stat(path.c_str(), &st)) == 0 && S_ISDIR(st.st_mode);
+        }
+        // a trailing "**" matches files as well as directories
+        if (recursive && is_dir)
+          items.push_back(Item{path, item.segment});
+        else if (recursive && last)
+          matches.push_back(path);
+        else if (!recursive && last)
+          matches.push_back(path);
+        else if (!recursive && is_dir)
+          items.push_back(Item{path, item.segment + 1});
       }
-      nfinal--;
+      closedir(dir);
     }
+#endif
+    std::vector<std::string> segments_;
+    std::deque<Item> queue_;
+    std::vector<std::string> matches_;
+    size_t busy_;
+    bool cancelled_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+  };
 
-    // check that all of the required arguments have been encountered
-    if (nrequired > 0 || nfinal > 0)
-      argumentError(std::string("too few required arguments passed to ").append(app_name_), true);
+  void expandGlob(size_t N, const std::string &pattern)
+  {
+    unsigned glob = argumentAt(N).glob;
+    std::vector<std::string> sorted;
+    size_t found = 0;
+    GlobWalker walker(pattern);
+    walker.run([&](const std::string &path) {
+      found++;
+      if (glob & GLOB_UNIQUE)
+      {
+        if (glob_seen_.size() <= N)
+          glob_seen_.resize(N + 1);
+        if (!glob_seen_[N].insert(std::make_pair(path, 0)).second)
+          return;
+      }
+      // matches are inputs, so the limits stop the walk before they are
+      // buffered for sorting
+      checkInput(path.size());
+      if ((glob & GLOB_SORT) && limits_.max_values && delivered_[N] + sorted.size() >= limits_.max_values)
+        argumentError(limitError(std::string("too many inputs to ").append(argumentAt(N).canonicalName()), limits_.max_values));
+      if (glob & GLOB_SORT)
+        sorted.push_back(path);
+      else
+        deliverInput(N, path);
+    });
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t n = 0; n < sorted.size(); ++n)
+      deliverInput(N, sorted[n]);
+    // like the shell, a pattern that matches nothing is passed on as is
+    if (found == 0)
+      deliverInput(N, pattern);
   }
 
   // --------------------------------------------------------------------------
-  // Retrieve
+  // Typed storage
   // --------------------------------------------------------------------------
   template <typename T>
-  const T retrieve(const std::string &name)
+  static void resetSlot(Any &slot) { slot = T(); }
+  static bool storeFile(const Argument &, Any &slot, size_t, const std::string &el, std::string &, size_t)
   {
-    if (index_.count(delimit(name)) == 0)
-      throw std::out_of_range("Key not found");
-    else if (count(name) == 0)
-      throw std::out_of_range("Value not found");
-
-    size_t N = index_[delimit(name)];
-    return variables_[N].retrieve<T>();
+    // accept the conventional @path spelling for file payloads
+    slot.castTo<MappedFile>().open(el.size() > 1 && el[0] == '@' ? el.substr(1) : el);
+    return true;
   }
 
-  // --------------------------------------------------------------------------
+  // conversion of a single input, the characters [begin, end), to each
+  // supported element type. The numeric conversions stop at the first
+  // character that cannot continue a number, so the input need not be
+  // terminated as long as a delimiter follows it
+  template <typename T>
+  static bool convertSigned(const char *begin, const char *end, T &out, std::string &error)
+  {
+    char *stop = 0;
+    errno = 0;
+    // base 10 as std::stoi reads it, so "010" is ten rather than octal.
+    // strtoll would skip leading whitespace, which is not part of a number
+    long long value = strtoll(begin, &stop, 10);
+    if (begin == end || std::isspace((unsigned char)*begin) || stop != end)
+    {
+      error = "expected an integer";
+      return false;
+    }
+    if (errno == ERANGE || value < (long long)std::numeric_limits<T>::min() || value > (long long)std::numeric_limits<T>::max())
+    {
+      error = "out of range";
+      return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+  }
+  template <typename T>
+  static bool convertUnsigned(const char *begin, const char *end, T &out, std::string &error)
+  {
+    char *stop = 0;
+    errno = 0;
+    // leading whitespace would hide a '-' that strtoull silently negates
+    unsigned long long value = strtoull(begin, &stop, 10);
+    if (begin == end || std::isspace((unsigned char)*begin) || *begin == '-' || stop != end)
+    {
+      error = "expected a non-negative integer";
+      return false;
+    }
+    if (errno == ERANGE || value > (unsigned long long)std::numeric_limits<T>::max())
+    {
+      error = "out of range";
+      return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+  }
+  template <typename T>
+  static bool convertFloat(const char *begin, const char *end, T &out, std::string &error)
+  {
+    char *stop = 0;
+    errno = 0;
+    long double value = strtold(begin, &stop);
+    if (begin == end || stop != end)
+    {
+      error = "expected a number";
+      return false;
+    }
+    if (errno == ERANGE || value > std::numeric_limits<T>::max() || value < -std::numeric_limits<T>::max())
+    {
+      error = "out of range";
+      return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+  }
+  static bool convert(const char *begin, const char *end, std::string &out, std::string &)
+  {
+    out.assign(begin, end);
+    return true;
+  }
+  static bool convert(const char *begin, const char *end, bool &out, std::string &error)
+  {
+    StringView el = {begin, (size_t)(end - begin)};
+    if (el == "true" || el == "1")
+      out = true;
+    else if (el == "false" || el == "0")
+      out = false;
+    else
+    {
+      error = "expected true or false";
+      return false;
+    }
+    return true;
+  }
+  static bool convert(const char *begin, const char *end, short &out, std::string &error) { return convertSigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, int &out, std::string &error) { return convertSigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, long &out, std::string &error) { return convertSigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, long long &out, std::string &error) { return convertSigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, unsigned short &out, std::string &error) { return convertUnsigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, unsigned &out, std::string &error) { return convertUnsigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, unsigned long &out, std::string &error) { return convertUnsigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, unsigned long long &out, std::string &error) { return convertUnsigned(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, float &out, std::string &error) { return convertFloat(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, double &out, std::string &error) { return convertFloat(begin, end, out, error); }
+  static bool convert(const char *begin, const char *end, long double &out, std::string &error) { return convertFloat(begin, end, out, error); }
+  template <typename T>
+  static bool convert(const std::string &el, T &out, std::string &error)
+  {
+    return convert(el.c_str(), el.c_str() + el.size(), out, error);
+  }
+
+  // first character in [p, end) that is one of the n characters of set
+  static const char *findFirst(const char *p, const char *end, const char *set, size_t n)
+  {
+#if defined(ARGPARSE_SSE2)
+    __m128i needles[8];
+    for (size_t k = 0; k < n; ++k)
+      needles[k] = _mm_set1_epi8(set[k]);
+    for (; end - p >= 16; p += 16)
+    {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      __m128i hits = _mm_cmpeq_epi8(chunk, needles[0]);
+      for (size_t k = 1; k < n; ++k)
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles[k]));
+      unsigned mask = _mm_movemask_epi8(hits);
+      if (mask)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+        return p + __builtin_ctz(mask);
+#else
+        for (;; ++p, mask >>= 1)
+          if (mask & 1)
+            return p;
+#endif
+      }
+    }
+#endif
+    for (; p != end; ++p)
+      if (memchr(set, *p, n))
+        return p;
+    return end;
+  }
+  // split an input into the items separated by arg.delimiter, converting
+  // each in place. Integer items may also be ranges: first-last, or
+  // first-last:step
+  template <typename T>
+  static bool storeList(const Argument &arg, Any &slot, size_t, const std::string &el, std::string &error, size_t max_items)
+  {
+    std::vector<T> &values = slot.castTo<std::vector<T> >();
+    const char *p = el.c_str(), *end = p + el.size();
+    for (;; ++p)
+    {
+      const char *stop = findFirst(p, end, &arg.delimiter, 1);
+      if (!appendItem(p, stop, values, max_items, error, std::integral_constant<bool, std::numeric_limits<T>::is_integer && !std::is_same<T, bool>::value>()))
+        return false;
+      if (stop == end)
+        return true;
+      p = stop;
+    }
+  }
+  template <typename T>
+  static bool appendItem(const char *begin, const char *end, std::vector<T> &values, size_t max_items, std::string &error, std::false_type)
+  {
+    if (values.size() >= max_items)
+    {
+      error = "too many items";
+      return false;
+    }
+    values.push_back(T());
+    return convert(begin, end, values.back(), error);
+  }
+  // items a single range may expand to when Limits::max_values is not set
+  static const size_t max_range_items = 64 * 1024;
+  template <typename T>
+  static bool appendItem(const char *begin, const char *end, std::vector<T> &values, size_t max_items, std::string &error, std::true_type)
+  {
+    // a leading '-' is the sign of the first bound
+    const char *dash = end - begin > 1 ? static_cast<const char *>(memchr(begin + 1, '-', end - begin - 1)) : 0;
+    if (!dash)
+      return appendItem(begin, end, values, max_items, error, std::false_type());
+    const char *colon = static_cast<const char *>(memchr(dash, ':', end - dash));
+    T first, last, step = 1;
+    if (!convert(begin, dash, first, error) || !convert(dash + 1, colon ? colon : end, last, error) ||
+        (colon && !convert(colon + 1, end, step, error)))
+      return false;
+    if (last < first || step <= 0)
+    {
+      error = "invalid range";
+      return false;
+    }
+    // count in unsigned arithmetic, which cannot overflow for any bounds
+    unsigned long long span = ((unsigned long long)last - (unsigned long long)first) / (unsigned long long)step;
+    // a short token can name billions of items, so ranges are capped even
+    // when no limit is set
+    if (max_items == npos && span >= max_range_items)
+    {
+      std::ostringstream msg;
+      msg << "range of more than " << max_range_items << " items";
+      error = msg.str();
+      return false;
+    }
+    if (span >= max_items - values.size())
+    {
+      error = "too many items";
+      return false;
+    }
+    for (unsigned long long n = 0; n <= span; ++n)
+      values.push_back(static_cast<T>((unsigned long long)first + n * (unsigned long long)step));
+    return true;
+  }
+
+  // split a key=value input on its first '=' into the map of the argument
+  static bool storeMap(const Argument &arg, Any &slot, size_t, const std::string &el, std::string &error, size_t max_items)
+  {
+    const char *equals = static_cast<const char *>(memchr(el.data(), '=', el.size()));
+    if (!equals || equals == el.data())
+    {
+      error = "expected key=value";
+      return false;
+    }
+    size_t key_size = equals - el.data();
+    // updating a key adds none, so only a new key counts against the limit
+    if (slot.castTo<FlatMap>().size() >= max_items && !slot.castTo<FlatMap>().contains(el.substr(0, key_size)))
+    {
+      error = "too many keys";
+      return false;
+    }
+    if (!slot.castTo<FlatMap>().insert(el.data(), key_size, equals + 1, el.size() - key_size - 1, DuplicatePolicy(arg.duplicates)))
+    {
+      error = std::string("duplicate key ").append(el, 0, key_size);
+      return false;
+    }
+    return true;
+  }
+  static void resetMap(Any &slot)
+  {
+    if (slot.holds<FlatMap>())
+      slot.castTo<FlatMap>().clear();
+    else
+      slot = FlatMap();
+  }
+
+  // add a cpulist input to the set of the argument, and check that every cpu
+  // (or node) is online when sysfs lists the online ones
+  static bool storeCpus(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+  {
+    return storeCpuList(slot, el, "/sys/devices/system/cpu/online", "cpu ", error);
+  }
+  static bool storeNodes(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+  {
+    return storeCpuList(slot, el, "/sys/devices/system/node/online", "node ", error);
+  }
+  static bool storeCpuList(Any &slot, const std::string &el, const char *online_path, const char *what, std::string &error)
+  {
+    CpuSet &set = slot.castTo<CpuSet>();
+    if (!set.parse(el, error))
+      return false;
+    CpuSet online;
+    if (!online.read(online_path))
+      return true;
+    for (CpuSet::const_iterator it = set.begin(); it != set.end(); ++it)
+      if (!online.test(*it))
+      {
+        std::ostringstream msg;
+        msg << what << *it << " is not online (online: " << online.str() << ")";
+        error = msg.str();
+        return false;
+      }
+    return true;
+  }
+  static void resetCpus(Any &slot)
+  {
+    if (slot.holds<CpuSet>())
+      slot.castTo<CpuSet>().clear();
+    else
+      slot = CpuSet();
+  }
+  void storeCpuSet(const std::string &name, bool (*store)(const Argument &, Any &, size_t, const std::string &, std::string &, size_t))
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (arg.fixed && arg.fixed_nargs == 0)
+      argumentError(std::string("cpu set argument ").append(name).append(" must take inputs"));
+    arg.store = store;
+    arg.reset = resetCpus;
+    variables_[N] = CpuSet();
+  }
+  std::shared_ptr<Validator> copyValidator(const std::string &name)
+  {
+    const Argument &arg = mutableArgument(argumentId(name));
+    return std::shared_ptr<Validator>(arg.validator ? new Validator(*arg.validator) : new Validator());
+  }
+  void storeUnits(const std::string &name, bool (*store)(const Argument &, Any &, size_t, const std::string &, std::string &, size_t),
+                  void (*reset)(Any &), const Any &empty)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (!arg.fixed || arg.fixed_nargs != 1)
+      argumentError(std::string("argument ").append(name).append(" must take exactly one input"));
+    arg.store = store;
+    arg.reset = reset;
+    variables_[N] = empty;
+  }
+
+  // sizes and durations: a decimal number with an optional fraction, scaled
+  // by a unit suffix. The integer part is scaled exactly with overflow
+  // checks, and only the fraction goes through floating point
+  struct Unit
+  {
+    const char *suffix;
+    uint64_t scale;
+  };
+  static bool scaleDecimal(const char *&p, const char *end, const Unit *units, uint64_t &out, std::string &error)
+  {
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    uint64_t integer = 0, fraction = 0, denominator = 1;
+    const char *digits = p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+      if (integer > (max - (*p - '0')) / 10)
+      {
+        error = "out of range";
+        return false;
+      }
+      integer = integer * 10 + (*p - '0');
+    }
+    if (p != end && *p == '.')
+      for (++p; p != end && *p >= '0' && *p <= '9'; ++p)
+        if (denominator < 1000000000000000000ULL)
+        {
+          fraction = fraction * 10 + (*p - '0');
+          denominator *= 10;
+        }
+    if (p == digits || (p - digits == 1 && *digits == '.'))
+    {
+      error = "expected a number";
+      return false;
+    }
+    // the longest suffix that matches
+    const Unit *unit = 0;
+    for (const Unit *u = units; u->suffix; ++u)
+    {
+      size_t size = strlen(u->suffix);
+      if ((size_t)(end - p) >= size && memcmp(p, u->suffix, size) == 0 && (!unit || size > strlen(unit->suffix)))
+        unit = u;
+    }
+    if (!unit)
+    {
+      error = "unknown unit";
+      return false;
+    }
+    p += strlen(unit->suffix);
+    if (integer > max / unit->scale)
+    {
+      error = "out of range";
+      return false;
+    }
+    out = integer * unit->scale;
+    uint64_t part = static_cast<uint64_t>((long double)fraction * unit->scale / denominator);
+    if (out > max - part)
+    {
+      error = "out of range";
+      return false;
+    }
+    out += part;
+    return true;
+  }
+  // a size in bytes, e.g. 4GiB, 1.5M or 512k. Decimal prefixes are powers of
+  // 1000 and binary prefixes powers of 1024, and a trailing B is optional
+  static bool parseSize(const std::string &el, uint64_t &out, std::string &error)
+  {
+    static const Unit units[] = {{"", 1}, {"B", 1},
+                                 {"k", 1000ULL}, {"K", 1000ULL}, {"M", 1000000ULL}, {"G", 1000000000ULL},
+                                 {"T", 1000000000000ULL}, {"P", 1000000000000000ULL}, {"E", 1000000000000000000ULL},
+                                 {"kB", 1000ULL}, {"KB", 1000ULL}, {"MB", 1000000ULL}, {"GB", 1000000000ULL},
+                                 {"TB", 1000000000000ULL}, {"PB", 1000000000000000ULL}, {"EB", 1000000000000000000ULL},
+                                 {"Ki", 1ULL << 10}, {"Mi", 1ULL << 20}, {"Gi", 1ULL << 30}, {"Ti", 1ULL << 40}, {"Pi", 1ULL << 50}, {"Ei", 1ULL << 60},
+                                 {"KiB", 1ULL << 10}, {"MiB", 1ULL << 20}, {"GiB", 1ULL << 30}, {"TiB", 1ULL << 40}, {"PiB", 1ULL << 50}, {"EiB", 1ULL << 60},
+                                 {0, 0}};
+    const char *p = el.c_str(), *end = p + el.size();
+    if (!scaleDecimal(p, end, units, out, error))
+      return false;
+    if (p != end)
+    {
+      error = "unknown unit";
+      return false;
+    }
+    return true;
+  }
+  // a duration, e.g. 250ms or 1h30m, as a sum of numbers each followed by
+  // one of the units ns, us, ms, s, m or h. A lone 0 needs no unit
+  static bool parseDuration(const std::string &el, std::chrono::nanoseconds &out, std::string &error)
+  {
+    static const Unit units[] = {{"ns", 1}, {"us", 1000ULL}, {"\xc2\xb5s", 1000ULL}, {"ms", 1000000ULL},
+                                 {"s", 1000000000ULL}, {"m", 60000000000ULL}, {"h", 3600000000000ULL}, {0, 0}};
+    const uint64_t max = std::numeric_limits<std::chrono::nanoseconds::rep>::max();
+    if (el == "0")
+    {
+      out = std::chrono::nanoseconds(0);
+      return true;
+    }
+    uint64_t total = 0;
+    const char *p = el.c_str(), *end = p + el.size();
+    do
+    {
+      uint64_t part;
+      if (!scaleDecimal(p, end, units, part, error))
+        return false;
+      if (part > max - total)
+      {
+        error = "out of range";
+        return false;
+      }
+      total += part;
+    } while (p != end);
+    out = std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(total));
+    return true;
+  }
+  static bool storeSize(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+  {
+    return parseSize(el, slot.castTo<uint64_t>(), error);
+  }
+  static bool storeDuration(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+  {
+    return parseDuration(el, slot.castTo<std::chrono::nanoseconds>(), error);
+  }
+
+  // resolve a choice to its value, or to the value of every input when the
+  // argument takes several
+  template <typename E>
+  static bool storeChoice(const Argument &arg, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+  {
+    size_t n = arg.choices->find(el.data(), el.size());
+    if (n == npos)
+    {
+      error = std::string("expected one of ").append(arg.choices->list());
+      return false;
+    }
+    if (arg.fixed && arg.fixed_nargs == 1)
+      slot.castTo<E>() = static_cast<E>(arg.choices->values[n]);
+    else
+      slot.castTo<std::vector<E> >().push_back(static_cast<E>(arg.choices->values[n]));
+    return true;
+  }
+
+  // how a slot of type T takes the inputs of an argument: scalars take one
+  // input, std::array and std::tuple exactly one input per element, and
+  // std::vector any number. Slots are reset in place between parses
+  template <typename T>
+  struct Slot
+  {
+    static bool fits(const Argument &arg) { return arg.fixed && arg.fixed_nargs == 1; }
+    static void reset(Any &slot)
+    {
+      if (slot.holds<T>())
+        slot.castTo<T>() = T();
+      else
+        slot = T();
+    }
+    static bool store(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+    {
+      return convert(el, slot.castTo<T>(), error);
+    }
+  };
+  template <typename T, size_t N>
+  struct Slot<std::array<T, N> >
+  {
+    static bool fits(const Argument &arg) { return arg.fixed && arg.fixed_nargs == N; }
+    static void reset(Any &slot)
+    {
+      if (slot.holds<std::array<T, N> >())
+        slot.castTo<std::array<T, N> >().fill(T());
+      else
+        slot = std::array<T, N>();
+    }
+    static bool store(const Argument &, Any &slot, size_t index, const std::string &el, std::string &error, size_t)
+    {
+      return convert(el, slot.castTo<std::array<T, N> >()[index % N], error);
+    }
+  };
+  template <size_t I, typename Tuple, bool End = I == std::tuple_size<Tuple>::value>
+  struct TupleElement
+  {
+    static bool store(Tuple &tuple, size_t index, const std::string &el, std::string &error)
+    {
+      if (index == I)
+        return convert(el, std::get<I>(tuple), error);
+      return TupleElement<I + 1, Tuple>::store(tuple, index, el, error);
+    }
+  };
+  template <size_t I, typename Tuple>
+  struct TupleElement<I, Tuple, true>
+  {
+    static bool store(Tuple &, size_t, const std::string &, std::string &error)
+    {
+      error = "too many inputs";
+      return false;
+    }
+  };
+  template <typename... Ts>
+  struct Slot<std::tuple<Ts...> >
+  {
+    static bool fits(const Argument &arg) { return arg.fixed && arg.fixed_nargs == sizeof...(Ts); }
+    static void reset(Any &slot)
+    {
+      if (slot.holds<std::tuple<Ts...> >())
+        slot.castTo<std::tuple<Ts...> >() = std::tuple<Ts...>();
+      else
+        slot = std::tuple<Ts...>();
+    }
+    static bool store(const Argument &, Any &slot, size_t index, const std::string &el, std::string &error, size_t)
+    {
+      return TupleElement<0, std::tuple<Ts...> >::store(slot.castTo<std::tuple<Ts...> >(), index, el, error);
+    }
+  };
+  template <typename T>
+  struct Slot<std::vector<T> >
+  {
+    static bool fits(const Argument &arg) { return !arg.fixed || arg.fixed_nargs > 1; }
+    static void reset(Any &slot)
+    {
+      if (slot.holds<std::vector<T> >())
+        slot.castTo<std::vector<T> >().clear();
+      else
+        slot = std::vector<T>();
+    }
+    static bool store(const Argument &, Any &slot, size_t, const std::string &el, std::string &error, size_t)
+    {
+      std::vector<T> &values = slot.castTo<std::vector<T> >();
+      values.push_back(T());
+      return convert(el, values.back(), error);
+    }
+  };
+
+  // --------------------------------------------------------------------------
+  // Validators
+  // --------------------------------------------------------------------------
+  // a set of bytes, also kept as its runs of consecutive bytes so that short
+  // classes can be tested 16 bytes at a time
+  struct ByteSet
+  {
+    ByteSet() : nruns(0) { memset(bits, 0, sizeof(bits)); }
+    uint64_t bits[4];
+    unsigned char first[8];
+    unsigned char last[8];
+    // the number of runs, or 0 if there are more than 8
+    size_t nruns;
+    void add(unsigned char c) { bits[c / 64] |= (uint64_t)1 << (c % 64); }
+    bool test(unsigned char c) const { return (bits[c / 64] >> (c % 64)) & 1; }
+    void invert()
+    {
+      for (size_t w = 0; w < 4; ++w)
+        bits[w] = ~bits[w];
+    }
+    void merge(const ByteSet &other)
+    {
+      for (size_t w = 0; w < 4; ++w)
+        bits[w] |= other.bits[w];
+    }
+    void findRuns()
+    {
+      nruns = 0;
+      for (unsigned c = 0; c < 256; ++c)
+      {
+        if (!test(c) || (c > 0 && test(c - 1)))
+          continue;
+        if (nruns == 8)
+        {
+          nruns = 0;
+          return;
+        }
+        unsigned end = c;
+        while (end < 255 && test(end + 1))
+          ++end;
+        first[nruns] = c;
+        last[nruns++] = end;
+      }
+    }
+    bool matches(const char *p, size_t size) const
+    {
+#if defined(ARGPARSE_SSE2)
+      if (nruns > 0 && size >= 16)
+      {
+        // c is in [first, last] when (c - first) saturating-minus
+        // (last - first) is zero, treating the bytes as unsigned
+        __m128i firsts[8], spans[8];
+        const __m128i zero = _mm_setzero_si128();
+        for (size_t k = 0; k < nruns; ++k)
+        {
+          firsts[k] = _mm_set1_epi8((char)first[k]);
+          spans[k] = _mm_set1_epi8((char)(last[k] - first[k]));
+        }
+        for (; size >= 16; p += 16, size -= 16)
+        {
+          __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+          __m128i in = zero;
+          for (size_t k = 0; k < nruns; ++k)
+            in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(chunk, firsts[k]), spans[k]), zero));
+          if (_mm_movemask_epi8(in) != 0xFFFF)
+            return false;
+        }
+      }
+#endif
+      for (size_t n = 0; n < size; ++n)
+        if (!test(p[n]))
+          return false;
+      return true;
+    }
+  };
+
+  // a compiled subset of regular expressions: literals, '.', escapes
+  // (\d \w \s and their negations), bracket classes, grouping, alternation
+  // and the quantifiers * + ? {n} {n,} {n,m}. Patterns must match the whole
+  // input. The pattern is parsed into a tree, built into an NFA back to
+  // front, and turned into a DFA table by subset construction
+  class Pattern
+  {
+  public:
+    static const size_t max_states = 4096;
+    bool compile(const std::string &pattern, std::string &error)
+    {
+      nodes_.clear();
+      nfa_.clear();
+      p_ = pattern.c_str();
+      end_ = p_ + pattern.size();
+      // anchors are implied
+      if (p_ != end_ && *p_ == '^')
+        ++p_;
+      if (end_ != p_ && end_[-1] == '$' && (end_ - p_ < 2 || end_[-2] != '\\'))
+        --end_;
+      error_.clear();
+      int root = parseAlternation();
+      if (error_.empty() && p_ != end_)
+        error_ = "unbalanced ')'";
+      if (!error_.empty())
+      {
+        error = error_;
+        return false;
+      }
+      Nfa match = {Nfa::MATCH, ByteSet(), -1, -1};
+      nfa_.push_back(match);
+      int start = build(root, 0);
+      return determinize(start, error);
+    }
+    bool matches(const char *p, size_t size) const
+    {
+      int state = 0;
+      for (size_t n = 0; n < size && state >= 0; ++n)
+        state = table_[state * 256 + (unsigned char)p[n]];
+      return state >= 0 && accept_[state];
+    }
+
+  private:
+    struct Node
+    {
+      enum Kind
+      {
+        EMPTY,
+        SET,
+        CONCAT,
+        ALTERNATE,
+        REPEAT
+      } kind;
+      ByteSet set;
+      int left;
+      int right;
+      // bounds of a repetition, max < 0 if unbounded
+      int min;
+      int max;
+    };
+    struct Nfa
+    {
+      enum Kind
+      {
+        SET,
+        SPLIT,
+        MATCH
+      } kind;
+      ByteSet set;
+      int out;
+      int out1;
+    };
+    int node(Node::Kind kind, int left = -1, int right = -1, int min = 0, int max = 0)
+    {
+      Node n = {kind, ByteSet(), left, right, min, max};
+      nodes_.push_back(n);
+      return nodes_.size() - 1;
+    }
+    int parseAlternation()
+    {
+      int left = parseConcatenation();
+      while (error_.empty() && p_ != end_ && *p_ == '|')
+      {
+        ++p_;
+        int right = parseConcatenation();
+        left = node(Node::ALTERNATE, left, right);
+      }
+      return left;
+    }
+    int parseConcatenation()
+    {
+      int left = node(Node::EMPTY);
+      while (error_.empty() && p_ != end_ && *p_ != '|' && *p_ != ')')
+        left = node(Node::CONCAT, left, parseRepetition());
+      return left;
+    }
+    int parseRepetition()
+    {
+      int atom = parseAtom();
+      while (error_.empty() && p_ != end_)
+      {
+        int min, max;
+        if (*p_ == '*')
+          min = 0, max = -1;
+        else if (*p_ == '+')
+          min = 1, max = -1;
+        else if (*p_ == '?')
+          min = 0, max = 1;
+        else if (*p_ == '{')
+        {
+          if (!parseBounds(min, max))
+            return atom;
+          atom = node(Node::REPEAT, atom, -1, min, max);
+          continue;
+        }
+        else
+          break;
+        ++p_;
+        atom = node(Node::REPEAT, atom, -1, min, max);
+      }
+      return atom;
+    }
+    bool parseBounds(int &min, int &max)
+    {
+      ++p_;
+      if (!parseCount(min))
+        return false;
+      max = min;
+      if (p_ != end_ && *p_ == ',')
+      {
+        ++p_;
+        max = -1;
+        if (p_ != end_ && *p_ != '}' && !parseCount(max))
+          return false;
+      }
+      if (p_ == end_ || *p_ != '}' || (max >= 0 && max < min))
+      {
+        error_ = "invalid repetition";
+        return false;
+      }
+      ++p_;
+      return true;
+    }
+    bool parseCount(int &count)
+    {
+      if (p_ == end_ || !isdigit((unsigned char)*p_))
+      {
+        error_ = "invalid repetition";
+        return false;
+      }
+      for (count = 0; p_ != end_ && isdigit((unsigned char)*p_); ++p_)
+        if ((count = count * 10 + (*p_ - '0')) > 1000)
+        {
+          error_ = "repetition count too large";
+          return false;
+        }
+      return true;
+    }
+    int parseAtom()
+    {
+      if (p_ == end_ || *p_ == '*' || *p_ == '+' || *p_ == '?' || *p_ == '{')
+      {
+        error_ = "nothing to repeat";
+        return -1;
+      }
+      if (*p_ == '(')
+      {
+        ++p_;
+        int inner = parseAlternation();
+        if (error_.empty() && (p_ == end_ || *p_ != ')'))
+          error_ = "missing ')'";
+        ++p_;
+        return inner;
+      }
+      int atom = node(Node::SET);
+      if (*p_ == '[')
+        parseClass(nodes_[atom].set);
+      else if (*p_ == '.')
+      {
+        nodes_[atom].set.invert();
+        ++p_;
+      }
+      else if (*p_ == '\\')
+        parseEscape(nodes_[atom].set);
+      else
+        nodes_[atom].set.add(*p_++);
+      return atom;
+    }
+    void parseEscape(ByteSet &set)
+    {
+      if (++p_ == end_)
+      {
+        error_ = "trailing '\\'";
+        return;
+      }
+      char c = *p_++;
+      // control characters, as pairs of escape and character
+      static const char controls[] = "n\nt\tr\rf\fv\v";
+      for (size_t k = 0; k + 1 < sizeof(controls); k += 2)
+        if (c == controls[k])
+        {
+          set.add(controls[k + 1]);
+          return;
+        }
+      ByteSet shorthand;
+      switch (tolower(c))
+      {
+      case 'd':
+        addRange(shorthand, '0', '9');
+        break;
+      case 'w':
+        addRange(shorthand, 'a', 'z');
+        addRange(shorthand, 'A', 'Z');
+        addRange(shorthand, '0', '9');
+        shorthand.add('_');
+        break;
+      case 's':
+        for (const char *s = " \t\n\r\f\v"; *s; ++s)
+          shorthand.add(*s);
+        break;
+      default:
+        set.add(c);
+        return;
+      }
+      if (isupper((unsigned char)c))
+        shorthand.invert();
+      set.merge(shorthand);
+    }
+    static void addRange(ByteSet &set, unsigned char first, unsigned char last)
+    {
+      for (unsigned c = first; c <= last; ++c)
+        set.add(c);
+    }
+
+  public:
+    // a bracket class such as [^a-z_], starting at p
+    bool parseClass(const char *&p, const char *end, ByteSet &set, std::string &error)
+    {
+      p_ = p;
+      end_ = end;
+      error_.clear();
+      parseClass(set);
+      p = p_;
+      error = error_;
+      return error_.empty();
+    }
+
+  private:
+    void parseClass(ByteSet &set)
+    {
+      ++p_;
+      bool negate = p_ != end_ && *p_ == '^';
+      p_ += negate;
+      for (bool first = true; p_ != end_ && (first || *p_ != ']'); first = false)
+      {
+        ByteSet item;
+        unsigned char lo;
+        if (*p_ == '\\')
+        {
+          parseEscape(item);
+          set.merge(item);
+          if (!error_.empty())
+            return;
+          if (p_[-2] != '\\' || isalpha((unsigned char)p_[-1]))
+            continue;
+          lo = p_[-1];
+        }
+        else
+          lo = *p_++;
+        if (p_ + 1 < end_ && *p_ == '-' && p_[1] != ']')
+        {
+          unsigned char hi = p_[1] == '\\' && p_ + 2 < end_ ? p_[2] : p_[1];
+          p_ += p_[1] == '\\' ? 3 : 2;
+          if (hi < lo)
+          {
+            error_ = "invalid range in class";
+            return;
+          }
+          addRange(set, lo, hi);
+        }
+        else
+          set.add(lo);
+      }
+      if (p_ == end_)
+      {
+        error_ = "missing ']'";
+        return;
+      }
+      ++p_;
+      if (negate)
+        set.invert();
+    }
+
+    // build the NFA of node n, continuing to state next, and return its start
+    int build(int n, int next)
+    {
+      const Node &node = nodes_[n];
+      switch (node.kind)
+      {
+      case Node::EMPTY:
+        return next;
+      case Node::SET:
+        return state(Nfa::SET, next, -1, &node.set);
+      case Node::CONCAT:
+      {
+        int right = build(node.right, next);
+        return build(nodes_[n].left, right);
+      }
+      case Node::ALTERNATE:
+      {
+        int left = build(node.left, next);
+        int right = build(nodes_[n].right, next);
+        return state(Nfa::SPLIT, left, right);
+      }
+      case Node::REPEAT:
+        break;
+      }
+      int child = node.left, min = node.min, max = node.max;
+      // the optional copies, then the required ones, back to front
+      if (max < 0)
+      {
+        int loop = state(Nfa::SPLIT, -1, next);
+        int body = build(child, loop);
+        nfa_[loop].out = body;
+        next = loop;
+      }
+      else
+        for (int k = min; k < max; ++k)
+          next = state(Nfa::SPLIT, build(child, next), next);
+      for (int k = 0; k < min; ++k)
+        next = build(child, next);
+      return next;
+    }
+    int state(Nfa::Kind kind, int out, int out1, const ByteSet *set = 0)
+    {
+      Nfa s = {kind, set ? *set : ByteSet(), out, out1};
+      nfa_.push_back(s);
+      return nfa_.size() - 1;
+    }
+    // the SET and MATCH states reachable from states without reading input.
+    // seen is all zero on entry and on return
+    void closure(std::vector<int> &states, std::vector<char> &seen) const
+    {
+      std::vector<int> stack(states), visited;
+      states.clear();
+      while (!stack.empty())
+      {
+        int s = stack.back();
+        stack.pop_back();
+        if (s < 0 || seen[s])
+          continue;
+        seen[s] = 1;
+        visited.push_back(s);
+        if (nfa_[s].kind == Nfa::SPLIT)
+        {
+          stack.push_back(nfa_[s].out);
+          stack.push_back(nfa_[s].out1);
+        }
+        else
+          states.push_back(s);
+      }
+      std::sort(states.begin(), states.end());
+      for (size_t n = 0; n < visited.size(); ++n)
+        seen[visited[n]] = 0;
+    }
+    bool determinize(int start, std::string &error)
+    {
+      std::map<std::vector<int>, int> ids;
+      std::vector<std::vector<int> > sets;
+      std::vector<char> seen(nfa_.size(), 0);
+      std::vector<int> initial(1, start);
+      closure(initial, seen);
+      ids[initial] = 0;
+      sets.push_back(initial);
+      table_.clear();
+      accept_.clear();
+      for (size_t d = 0; d < sets.size(); ++d)
+      {
+        table_.resize((d + 1) * 256, -1);
+        accept_.push_back(0);
+        for (size_t n = 0; n < sets[d].size(); ++n)
+          accept_[d] |= nfa_[sets[d][n]].kind == Nfa::MATCH;
+        for (unsigned c = 0; c < 256; ++c)
+        {
+          std::vector<int> next;
+          for (size_t n = 0; n < sets[d].size(); ++n)
+          {
+            const Nfa &s = nfa_[sets[d][n]];
+            if (s.kind == Nfa::SET && s.set.test(c))
+              next.push_back(s.out);
+          }
+          if (next.empty())
+            continue;
+          closure(next, seen);
+          std::map<std::vector<int>, int>::iterator it = ids.find(next);
+          if (it == ids.end())
+          {
+            if (sets.size() == max_states)
+            {
+              error = "pattern is too complex";
+              return false;
+            }
+            it = ids.insert(std::make_pair(next, (int)sets.size())).first;
+            sets.push_back(next);
+          }
+          table_[d * 256 + c] = it->second;
+        }
+      }
+      nodes_.clear();
+      nfa_.clear();
+      return true;
+    }
+    // parser and builder state, released once compiled
+    const char *p_;
+    const char *end_;
+    std::string error_;
+    std::vector<Node> nodes_;
+    std::vector<Nfa> nfa_;
+    // next state of each state for each byte, or -1 once no match is possible
+    std::vector<int> table_;
+    std::vector<char> accept_;
+  };
+
+  // the checks every input of an argument must pass, shared by its copies
+  struct Validator
+  {
+    Validator() : has_chars(false), has_pattern(false) {}
+    bool has_chars;
+    ByteSet chars;
+    std::string chars_source;
+    bool has_pattern;
+    Pattern pattern;
+    std::string pattern_source;
+    bool check(const std::string &el, std::string &error) const
+    {
+      if (has_chars && !chars.matches(el.data(), el.size()))
+      {
+        error = std::string("expected only characters in [").append(chars_source).append("]");
+        return false;
+      }
+      if (has_pattern && !pattern.matches(el.data(), el.size()))
+      {
+        error = std::string("does not match ").append(pattern_source);
+        return false;
+      }
+      return true;
+    }
+  };
+
+  // --------------------------------------------------------------------------
+  // Parse state machine
+  // --------------------------------------------------------------------------
+  // tokens are fed one at a time. The last nfinal tokens belong to the final
+  // argument, so that many tokens are held back in a ring until the next one
+  // arrives or the input ends
+  static const size_t stream_buffer_size = 64 * 1024;
+
+  void beginParse(bool known_only = false)
+  {
+    if (!frozen_)
+      freeze();
+
+    const size_t final_id = finalId();
+    const Argument *final = final_id == npos ? 0 : &argumentAt(final_id);
+    state_.skip_first = ignore_first_;
+    state_.known_only = known_only;
+    state_.unknown = false;
+    state_.options_end = npos;
+    state_.position = 0;
+    state_.bytes = 0;
+    unknown_.clear();
+    state_.final = final_id;
+    state_.active = npos;
+    state_.consumed = 0;
+    state_.nrequired = final && final->required ? required_ - 1 : required_;
+    state_.nfinal = !final || !final->required ? 0 : (final->fixed ? final->fixed_nargs : (final->variable_nargs == '+' ? 1 : 0));
+    state_.held.resize(state_.nfinal);
+    state_.held_begin = 0;
+    state_.held_size = 0;
+    state_.ordered = true;
+    state_.nparsed = argumentCount();
+    stream_token_.clear();
+
+    resetInputs();
+    seen_.assign((argumentCount() + 63) / 64, 0);
+    derived_done_.clear();
+    derived_busy_.clear();
+    path_inflight_.clear();
+    path_batch_.clear();
+    path_status_.assign(argumentCount(), std::vector<unsigned>());
+    path_violations_.clear();
+    glob_seen_.clear();
+    delivered_.assign(argumentCount(), 0);
+  }
+  // continue the last parse with the arguments added since, keeping the
+  // inputs already parsed. The final argument has been resolved, and
+  // required arguments may now come in any order
+  void resumeParse()
+  {
+    if (!frozen_)
+      freeze();
+
+    state_.skip_first = false;
+    state_.known_only = false;
+    state_.unknown = false;
+    state_.active = npos;
+    state_.consumed = 0;
+    state_.nfinal = 0;
+    state_.held_size = 0;
+    state_.ordered = false;
+    state_.nrequired = 0;
+    resetInputs(state_.nparsed);
+    for (size_t N = 0; N < argumentCount(); ++N)
+      if (argumentAt(N).required && argumentAt(N).default_value.empty() && N != state_.final && !testBit(seen_, N))
+        state_.nrequired++;
+    state_.nparsed = argumentCount();
+
+    seen_.resize((argumentCount() + 63) / 64, 0);
+    derived_done_.clear();
+    derived_busy_.clear();
+    path_status_.resize(argumentCount());
+    path_violations_.clear();
+    delivered_.resize(argumentCount(), 0);
+  }
+  void feed(const std::string &el)
+  {
+    const size_t position = state_.position++;
+    checkLimits(el.size());
+    if (state_.skip_first)
+    {
+      // check if the app is named
+      state_.skip_first = false;
+      if (app_name_.empty())
+        app_name_ = el.substr(el.find_last_of("\\/") + 1);
+      return;
+    }
+    if (state_.nfinal == 0)
+      return feedArgument(el, position);
+    // hold el back, releasing the oldest held token once the ring is full
+    size_t n = state_.held.size();
+    if (state_.held_size == n)
+    {
+      std::string &oldest = state_.held[state_.held_begin];
+      feedArgument(oldest, position - n);
+      oldest = el;
+      state_.held_begin = (state_.held_begin + 1) % n;
+    }
+    else
+    {
+      state_.held[(state_.held_begin + state_.held_size++) % n] = el;
+    }
+  }
+  // fail as soon as the tokens fed so far exceed the limits
+  void checkLimits(size_t size)
+  {
+    if (limits_.max_tokens && state_.position > limits_.max_tokens)
+      argumentError(limitError("too many tokens", limits_.max_tokens));
+    checkInput(size);
+  }
+  // count an input of size bytes against the limits on each input and on all
+  // of them together
+  void checkInput(size_t size)
+  {
+    if (limits_.max_value_size && size > limits_.max_value_size)
+      argumentError(limitError("input too long", limits_.max_value_size));
+    state_.bytes += size;
+    if (limits_.max_bytes && state_.bytes > limits_.max_bytes)
+      argumentError(limitError("inputs too large", limits_.max_bytes));
+  }
+  static std::string limitError(const std::string &what, size_t limit)
+  {
+    std::ostringstream msg;
+    msg << what << " (limit " << limit << ")";
+    return msg.str();
+  }
+  // split a chunk of stream input on delimiter. A token may span chunks, and
+  // an empty chunk flushes the last token
+  void feedChunk(const char *data, size_t size, char delimiter)
+  {
+    const char *end = data + size;
+    while (data != end)
+    {
+      const char *stop = static_cast<const char *>(memchr(data, delimiter, end - data));
+      stream_token_.append(data, stop ? stop : end);
+      // a token without a delimiter must not grow without bound
+      if (limits_.max_value_size && stream_token_.size() > limits_.max_value_size)
+        argumentError(limitError("input too long", limits_.max_value_size));
+      if (limits_.max_bytes && state_.bytes + stream_token_.size() > limits_.max_bytes)
+        argumentError(limitError("inputs too large", limits_.max_bytes));
+      if (!stop)
+        return;
+      if (!stream_token_.empty())
+        feed(stream_token_);
+      stream_token_.clear();
+      data = stop + 1;
+    }
+    if (size == 0 && !stream_token_.empty())
+    {
+      feed(stream_token_);
+      stream_token_.clear();
+    }
+  }
+  void feedArgument(const std::string &el, size_t position)
+  {
+    const size_t active = state_.active;
+    const Argument &arg = active == npos ? none_ : argumentAt(active);
+    // "--" ends the options: the tokens after it are inputs, even those
+    // starting with '-' or naming an argument. It stays with the tokens of
+    // an unknown option, so parsePending() meets it again at its position
+    if (el == "--" && (state_.options_end == npos || state_.options_end == position))
+    {
+      state_.options_end = position;
+      if (state_.unknown)
+        skipUnknown(position);
+      return;
+    }
+    const bool literal = state_.options_end != npos && position > state_.options_end;
+    const size_t N = literal ? npos : lookup(el);
+
+    //  check if the element is a key
+    if (N == npos)
+    {
+      // a mistyped option should not be swallowed as an input. When only
+      // known arguments are parsed, it and its inputs are set aside instead
+      if (!literal && looksLikeOption(el))
+      {
+        if (!state_.known_only)
+          unknownArgument(el);
+        checkConsumed(el);
+        state_.active = npos;
+        state_.unknown = true;
+        return skipUnknown(position);
+      }
+      if (state_.unknown)
+        return skipUnknown(position);
+      // input
+      // is the current active argument expecting more inputs? If not, a
+      // variadic final argument collects the remaining inputs
+      if (arg.fixed && arg.fixed_nargs <= state_.consumed)
+      {
+        if ((state_.final == npos || argumentAt(state_.final).fixed) && state_.known_only)
+          return skipUnknown(position);
+        if (state_.final == npos || argumentAt(state_.final).fixed)
+          argumentError(std::string("attempt to pass too many inputs to ").append(arg.canonicalName()), true);
+        storeInput(state_.final, el);
+        setBit(seen_, state_.final);
+        return;
+      }
+      storeInput(active, el);
+      state_.consumed++;
+      return;
+    }
+
+    // new key!
+    // has the active argument consumed enough elements?
+    checkConsumed(el);
+    state_.unknown = false;
+    const Argument &next = argumentAt(N);
+    state_.active = N;
+    state_.consumed = 0;
+    setBit(seen_, N);
+    // if nargs == 0(store_ture, that means no more argument)
+    if (next.fixed && next.fixed_nargs == 0)
+    {
+      variables_[N].castTo<std::string>() = "true";
+      clearBit(cached_, N);
+    }
+
+    // check if we've satisfied the required arguments
+    if (state_.ordered && !next.required && state_.nrequired > 0)
+      argumentError(std::string("encountered required argument ")
+                        .append(el)
+                        .append(" when expecting more required arguments"),
+                    true);
+    if (next.required && next.default_value.empty())
+      state_.nrequired--;
+  }
+  // record the token at position as unrecognized, extending the last range
+  void skipUnknown(size_t position)
+  {
+    if (!unknown_.empty() && unknown_.back().second == position)
+      unknown_.back().second++;
+    else
+      unknown_.push_back(Range(position, position + 1));
+  }
+  void checkConsumed(const std::string &el)
+  {
+    if (state_.active == npos)
+      return;
+    const Argument &arg = argumentAt(state_.active);
+    if ((arg.fixed && arg.fixed_nargs != state_.consumed) ||
+        (!arg.fixed && arg.variable_nargs == '+' && state_.consumed < 1))
+    {
+      if (el.empty())
+        argumentError(std::string("too few inputs passed to argument ").append(arg.canonicalName()), true);
+      argumentError(std::string("encountered argument ")
+                        .append(el)
+                        .append(" when expecting more inputs to ")
+                        .append(arg.canonicalName()),
+                    true);
+    }
+  }
+  void endParse()
+  {
+    // the held tokens are the inputs of the final argument
+    size_t nfinal = 0;
+    for (size_t n = 0; n < state_.held_size; ++n)
+    {
+      const std::string &el = state_.held[(state_.held_begin + n) % state_.held.size()];
+      const size_t position = state_.position - state_.held_size + n;
+      if (state_.options_end == npos && el == "--")
+      {
+        state_.options_end = position;
+        continue;
+      }
+      const bool literal = state_.options_end != npos && position > state_.options_end;
+      // check if we accidentally find an argument specifier
+      if (!literal && lookup(el) != npos)
+        argumentError(std::string("encountered argument specifier ")
+                          .append(el)
+                          .append(" while parsing final required inputs"),
+                      true);
+      if (!literal && looksLikeOption(el) && state_.known_only)
+      {
+        skipUnknown(position);
+        continue;
+      }
+      if (!literal && looksLikeOption(el))
+        unknownArgument(el);
+      storeInput(state_.final, el);
+      setBit(seen_, state_.final);
+      nfinal++;
+    }
+    checkConsumed("");
+
+    // check that all of the required arguments have been encountered
+    if (state_.nrequired > 0 || nfinal < state_.nfinal)
+      argumentError(std::string("too few required arguments passed to ").append(app_name_), true);
+    checkConstraints();
+    validatePaths();
+  }
+
+  // --------------------------------------------------------------------------
+  // Error handling
+  // --------------------------------------------------------------------------
+  void argumentError(const std::string &msg, bool show_usage = false)
+  {
+    if (use_exceptions_)
+      throw std::invalid_argument(msg);
+    std::cerr << "ArgumentParser error: " << msg << std::endl;
+    if (show_usage)
+      std::cerr << usage() << std::endl;
+    exit(-5);
+  }
+
+  // --------------------------------------------------------------------------
+  // Suggestions
+  // --------------------------------------------------------------------------
+  static bool looksLikeOption(const std::string &el)
+  {
+    // a lone '-' (stdin) and negative numbers are inputs, not options
+    if (el.size() < 2 || el[0] != '-')
+      return false;
+    return !std::isdigit((unsigned char)el[1]) && el[1] != '.';
+  }
+  // Levenshtein distance of text from a pattern of 1 to 64 characters, using
+  // Hyyro's formulation of Myers' bit-parallel algorithm. peq[c] holds the
+  // positions at which c occurs in the pattern.
+  static size_t editDistance(const uint64_t *peq, size_t m, const std::string &text)
+  {
+    const uint64_t last = (uint64_t)1 << (m - 1);
+    uint64_t pv = ~(uint64_t)0, mv = 0;
+    size_t score = m;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+      uint64_t eq = peq[(unsigned char)text[i]];
+      uint64_t xv = eq | mv;
+      uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+      uint64_t ph = mv | ~(xh | pv);
+      uint64_t mh = pv & xh;
+      if (ph & last)
+        score++;
+      else if (mh & last)
+        score--;
+      ph = (ph << 1) | 1;
+      mh <<= 1;
+      pv = mh | ~(xv | ph);
+      mv = ph & xv;
+    }
+    return score;
+  }
+  // plain dynamic-programming fallback for patterns longer than a word
+  static size_t editDistance(const std::string &a, const std::string &b)
+  {
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j)
+      row[j] = j;
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+      size_t diag = row[0];
+      row[0] = i;
+      for (size_t j = 1; j <= b.size(); ++j)
+      {
+        size_t up = row[j];
+        row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diag + (a[i - 1] != b[j - 1]));
+        diag = up;
+      }
+    }
+    return row[b.size()];
+  }
+  void rankNames(const std::string &el, const uint64_t *peq, size_t max_distance,
+                 std::vector<std::pair<size_t, std::string> > &candidates) const
+  {
+    const size_t m = el.size();
+    for (IndexMap::const_iterator it = index_.begin(); it != index_.end(); ++it)
+    {
+      const std::string &name = it->first;
+      // names whose length is out of reach cannot be within max_distance
+      size_t gap = name.size() > m ? name.size() - m : m - name.size();
+      if (gap > max_distance || name == final_name_)
+        continue;
+      size_t d = m <= 64 ? editDistance(peq, m, name) : editDistance(el, name);
+      if (d <= max_distance)
+        candidates.push_back(std::make_pair(d, name));
+    }
+    for (size_t n = 0; n < parents_.size(); ++n)
+      parents_[n].parser->rankNames(el, peq, max_distance, candidates);
+  }
+  std::vector<std::string> suggest(const std::string &el) const
+  {
+    // accept roughly one typo per three characters of the stripped name
+    const size_t m = el.size();
+    const size_t max_distance = std::max((size_t)1, strip(el).size() / 3);
+    uint64_t peq[256] = {0};
+    for (size_t i = 0; i < m && m <= 64; ++i)
+      peq[(unsigned char)el[i]] |= (uint64_t)1 << i;
+
+    std::vector<std::pair<size_t, std::string> > candidates;
+    rankNames(el, peq, max_distance, candidates);
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<std::string> out;
+    for (size_t n = 0; n < candidates.size() && n < 3; ++n)
+    {
+      if (candidates[n].first != candidates[0].first)
+        break;
+      out.push_back(candidates[n].second);
+    }
+    return out;
+  }
+  void unknownArgument(const std::string &el)
+  {
+    std::string msg = std::string("unrecognized argument ").append(el);
+    std::vector<std::string> names = suggest(el);
+    for (size_t n = 0; n < names.size(); ++n)
+      msg.append(n == 0 ? ". Did you mean " : (n + 1 == names.size() ? " or " : ", ")).append(names[n]);
+    if (!names.empty())
+      msg.append("?");
+    argumentError(msg, true);
+  }
+
+public:
+  // --------------------------------------------------------------------------
+  // Limits
+  // --------------------------------------------------------------------------
+  /*! @struct Limits
+   *  @brief Bounds on the input of a parse. A limit of 0 is no limit.
+   */
+  struct Limits
+  {
+    Limits() : max_tokens(0), max_value_size(0), max_values(0), max_bytes(0) {}
+    // tokens, counting the program name
+    size_t max_tokens;
+    // bytes in a single token
+    size_t max_value_size;
+    // inputs, or items of a list or map, stored for one argument
+    size_t max_values;
+    // bytes in all tokens together
+    size_t max_bytes;
+  };
+
+  // --------------------------------------------------------------------------
+  // Tokenizer
+  // --------------------------------------------------------------------------
+  // the tokens [first, second) of a command line
+  typedef std::pair<size_t, size_t> Range;
+
+  /*! @class StringView
+   *  @brief A non-owning reference to a run of characters.
+   */
+  struct StringView
+  {
+    const char *data;
+    size_t size;
+    std::string str() const { return std::string(data, size); }
+    bool operator==(const std::string &other) const { return other.size() == size && other.compare(0, size, data, size) == 0; }
+  };
+
+  /*! @class Tokenizer
+   *  @brief Splits a command string into tokens following POSIX shell
+   *  quoting: single quotes, double quotes and backslash escapes.
+   *
+   *  Tokens without quotes or escapes are views into the input. The others
+   *  are unescaped into a buffer owned by the tokenizer, which is sized to
+   *  the rest of the input at the first of them so views never move. All views stay valid until the
+   *  next call to tokenize() and as long as the input does.
+   */
+  class Tokenizer
+  {
+  public:
+    // returns false on an unterminated quote or a trailing backslash. At most
+    // max_tokens tokens are split off, or all of them if it is 0
+    bool tokenize(const char *line, size_t size, size_t max_tokens = 0)
+    {
+      tokens_.clear();
+      char *out = 0;
+      const char *p = line, *end = line + size;
+      for (;;)
+      {
+        while (p != end && (*p == ' ' || *p == '\t' || *p == '\n'))
+          ++p;
+        if (p == end || (max_tokens && tokens_.size() == max_tokens))
+          return true;
+        const char *start = p;
+        p = findFirst(p, end, " \t\n'\"\\", 6);
+        if (p == end || *p == ' ' || *p == '\t' || *p == '\n')
+        {
+          StringView view = {start, (size_t)(p - start)};
+          tokens_.push_back(view);
+          continue;
+        }
+        // slow path: unescape the token into the buffer, which is sized to
+        // the rest of the input the first time it is needed
+        if (!out)
+        {
+          if (buffer_.size() < (size_t)(end - start))
+            buffer_.resize(end - start);
+          out = &buffer_[0];
+        }
+        char *token = out;
+        out = std::copy(start, p, out);
+        while (p != end && *p != ' ' && *p != '\t' && *p != '\n')
+        {
+          const char *next;
+          switch (*p)
+          {
+          case '\'':
+            next = static_cast<const char *>(memchr(p + 1, '\'', end - p - 1));
+            if (!next)
+              return false;
+            out = std::copy(p + 1, next, out);
+            p = next + 1;
+            break;
+          case '"':
+            for (++p;; p += 2)
+            {
+              next = findFirst(p, end, "\"\\", 2);
+              out = std::copy(p, next, out);
+              p = next;
+              if (p == end)
+                return false;
+              if (*p == '"')
+                break;
+              if (p + 1 == end)
+                return false;
+              // within double quotes a backslash only escapes $ ` " \ and newline
+              if (p[1] != '$' && p[1] != '`' && p[1] != '"' && p[1] != '\\' && p[1] != '\n')
+                *out++ = '\\';
+              if (p[1] != '\n')
+                *out++ = p[1];
+            }
+            ++p;
+            break;
+          case '\\':
+            if (p + 1 == end)
+              return false;
+            if (p[1] != '\n')
+              *out++ = p[1];
+            p += 2;
+            break;
+          default:
+            next = findFirst(p, end, " \t\n'\"\\", 6);
+            out = std::copy(p, next, out);
+            p = next;
+          }
+        }
+        StringView view = {token, (size_t)(out - token)};
+        tokens_.push_back(view);
+      }
+    }
+    bool tokenize(const std::string &line, size_t max_tokens = 0) { return tokenize(line.data(), line.size(), max_tokens); }
+    // a second argument after a C string is its size, as above
+    bool tokenize(const char *line) { return tokenize(line, strlen(line)); }
+    // views into a temporary would dangle as soon as tokenize() returns
+    bool tokenize(std::string &&line, size_t max_tokens = 0) = delete;
+    const std::vector<StringView> &tokens() const { return tokens_; }
+
+  private:
+    std::vector<StringView> tokens_;
+    std::vector<char> buffer_;
+  };
+
+private:
+  // --------------------------------------------------------------------------
+  // Member variables
+  // --------------------------------------------------------------------------
+  IndexMap index_;
+  bool ignore_first_;
+  bool use_exceptions_;
+  size_t required_;
+  std::string app_name_;
+  std::string final_name_;
+  std::vector<Argument> arguments_;
+  std::vector<Parent> parents_;
+  size_t parent_size_;
+  std::vector<Any> variables_;
+  // conversions memoized by retrieve<T>(), valid while the bit is set
+  std::vector<Any> cache_;
+  Bitset cached_;
+  std::vector<TrieNode> trie_;
+  std::vector<size_t> ns_order_;
+  bool trie_dirty_;
+  std::vector<Constraint> constraints_;
+  Bitset seen_;
+  std::vector<Derived> derived_;
+  std::vector<size_t> derived_of_;
+  Bitset derived_done_;
+  Bitset derived_busy_;
+  bool frozen_;
+  std::string help_pending_;
+  std::string help_packed_;
+  std::vector<HelpChunk> help_chunks_;
+  size_t help_size_;
+  PathBatch path_batch_;
+  std::deque<std::future<PathBatch> > path_inflight_;
+  std::vector<std::vector<unsigned> > path_status_;
+  std::string path_violations_;
+  std::vector<IndexMap> glob_seen_;
+  std::vector<std::function<void(const std::string &)> > sinks_;
+  std::vector<size_t> delivered_;
+  struct ParseState
+  {
+    bool skip_first;
+    bool ordered;
+    size_t nparsed;
+    bool known_only;
+    bool unknown;
+    size_t position;
+    // position of the "--" that ended the options, or npos
+    size_t options_end;
+    // bytes fed so far
+    size_t bytes;
+    size_t final;
+    size_t active;
+    size_t consumed;
+    size_t nrequired;
+    size_t nfinal;
+    std::vector<std::string> held;
+    size_t held_begin;
+    size_t held_size;
+  } state_;
+  Argument none_;
+  std::vector<char> stream_buffer_;
+  std::string stream_token_;
+  Tokenizer tokenizer_;
+  std::vector<Range> unknown_;
+  Limits limits_;
+
+public:
+  enum PathCheck
+  {
+    PATH_EXISTS = 1,
+    PATH_READABLE = 2,
+    PATH_IS_DIR = 4,
+    PATH_IS_FILE = 8
+  };
+  enum GlobOption
+  {
+    GLOB_EXPAND = 1,
+    GLOB_SORT = 2,
+    GLOB_UNIQUE = 4
+  };
+  enum DuplicatePolicy
+  {
+    DUPLICATE_LAST,
+    DUPLICATE_FIRST,
+    DUPLICATE_ERROR
+  };
+
+  /*! @struct ArgSpec
+   *  @brief One row of a table of arguments passed to addArguments(). The
+   *  strings are borrowed for the duration of the call, and null strings are
+   *  treated as empty. The help is not copied, so it must outlive the parser,
+   *  as string literals do.
+   */
+  struct ArgSpec
+  {
+    const char *short_name;
+    const char *name;
+    char nargs;
+    const char *default_value;
+    bool required;
+    const char *help;
+  };
+
+  /*! @class MappedFile
+   *  @brief A read-only view of a file that is memory mapped the first time
+   *  its contents are accessed.
+   *
+   *  Copies share the path only and map the file again on their own access.
+   */
+  class MappedFile
+  {
+  public:
+    MappedFile() : data_(0), size_(0), mapped_(false) {}
+    MappedFile(const MappedFile &other) : path_(other.path_), data_(0), size_(0), mapped_(false) {}
+    MappedFile &operator=(const MappedFile &other)
+    {
+      if (this != &other)
+        open(other.path_);
+      return *this;
+    }
+    ~MappedFile() { close(); }
+    void open(const std::string &path)
+    {
+      close();
+      path_ = path;
+    }
+    const std::string &path() const { return path_; }
+    const char *data() const
+    {
+      map();
+      return data_;
+    }
+    size_t size() const
+    {
+      map();
+      return size_;
+    }
+    bool empty() const { return size() == 0; }
+
+  private:
+    void map() const
+    {
+      if (mapped_)
+        return;
+#if defined(_WIN32)
+      std::ifstream in(path_.c_str(), std::ios::binary);
+      if (!in)
+        throw std::runtime_error(std::string("cannot open ").append(path_));
+      buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      data_ = buffer_.data();
+      size_ = buffer_.size();
+#else
+      int fd = ::open(path_.c_str(), O_RDONLY);
+      struct stat st;
+      if (fd < 0 || fstat(fd, &st) != 0)
+      {
+        if (fd >= 0)
+          ::close(fd);
+        throw std::runtime_error(std::string("cannot open ").append(path_));
+      }
+      size_ = st.st_size;
+      data_ = "";
+      if (size_ > 0)
+      {
+        void *addr = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+          throw std::runtime_error(std::string("cannot map ").append(path_));
+        data_ = static_cast<const char *>(addr);
+      }
+      else
+        ::close(fd);
+#endif
+      mapped_ = true;
+    }
+    void close()
+    {
+#if !defined(_WIN32)
+      if (mapped_ && size_ > 0)
+        munmap(const_cast<char *>(data_), size_);
+#endif
+      data_ = 0;
+      size_ = 0;
+      mapped_ = false;
+    }
+    std::string path_;
+    mutable const char *data_;
+    mutable size_t size_;
+    mutable bool mapped_;
+#if defined(_WIN32)
+    mutable std::string buffer_;
+#endif
+  };
+
+  /*! @class FlatMap
+   *  @brief The key=value inputs of a map argument, in an open-addressing
+   *  hash table over a single arena of keys and values.
+   *
+   *  Entries keep their first insertion order. The views returned by a
+   *  FlatMap are invalidated when it is next modified, i.e. by a new parse.
+   */
+  class FlatMap
+  {
+  public:
+    FlatMap() : mask_(0) {}
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void clear()
+    {
+      arena_.clear();
+      entries_.clear();
+      std::fill(slots_.begin(), slots_.end(), 0);
+    }
+    bool contains(const std::string &key) const { return find(key.data(), key.size()) != npos; }
+    // the value of key, or fallback if the key is absent
+    std::string get(const std::string &key, const std::string &fallback = "") const
+    {
+      size_t n = find(key.data(), key.size());
+      return n == npos ? fallback : value(n).str();
+    }
+    bool get(const std::string &key, StringView &out) const
+    {
+      size_t n = find(key.data(), key.size());
+      if (n != npos)
+        out = value(n);
+      return n != npos;
+    }
+    // the n-th entry, in insertion order
+    StringView key(size_t n) const
+    {
+      StringView view = {arena_.data() + entries_[n].key, entries_[n].key_size};
+      return view;
+    }
+    StringView value(size_t n) const
+    {
+      StringView view = {arena_.data() + entries_[n].key + entries_[n].key_size, entries_[n].value_size};
+      return view;
+    }
+    // insert or update key. A duplicate key is resolved by policy, and false
+    // is returned if the policy rejects it
+    bool insert(const char *key, size_t key_size, const char *value, size_t value_size, DuplicatePolicy policy = DUPLICATE_LAST)
+    {
+      if (2 * (entries_.size() + 1) > slots_.size())
+        grow();
+      uint64_t hash = fnv1a(key, key_size);
+      size_t slot = hash & mask_;
+      for (; slots_[slot]; slot = (slot + 1) & mask_)
+      {
+        Entry &entry = entries_[slots_[slot] - 1];
+        if (entry.hash != hash || entry.key_size != key_size || arena_.compare(entry.key, key_size, key, key_size) != 0)
+          continue;
+        if (policy == DUPLICATE_ERROR)
+          return false;
+        if (policy == DUPLICATE_LAST)
+        {
+          // the superseded value is left in the arena until the next clear
+          entry.key = arena_.size();
+          entry.value_size = value_size;
+          arena_.append(key, key_size).append(value, value_size);
+        }
+        return true;
+      }
+      Entry entry = {hash, arena_.size(), key_size, value_size};
+      arena_.append(key, key_size).append(value, value_size);
+      entries_.push_back(entry);
+      slots_[slot] = entries_.size();
+      return true;
+    }
+
+  private:
+    struct Entry
+    {
+      uint64_t hash;
+      // the key at [key, key + key_size) of the arena, followed by the value
+      size_t key;
+      size_t key_size;
+      size_t value_size;
+    };
+    static uint64_t fnv1a(const char *data, size_t size)
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      for (size_t n = 0; n < size; ++n)
+        hash = (hash ^ (unsigned char)data[n]) * 1099511628211ULL;
+      return hash;
+    }
+    size_t find(const char *key, size_t key_size) const
+    {
+      if (entries_.empty())
+        return npos;
+      uint64_t hash = fnv1a(key, key_size);
+      for (size_t slot = hash & mask_; slots_[slot]; slot = (slot + 1) & mask_)
+      {
+        const Entry &entry = entries_[slots_[slot] - 1];
+        if (entry.hash == hash && entry.key_size == key_size && arena_.compare(entry.key, key_size, key, key_size) == 0)
+          return slots_[slot] - 1;
+      }
+      return npos;
+    }
+    // double the table, keeping it at most half full
+    void grow()
+    {
+      slots_.assign(std::max((size_t)16, 2 * slots_.size()), 0);
+      mask_ = slots_.size() - 1;
+      for (size_t n = 0; n < entries_.size(); ++n)
+      {
+        size_t slot = entries_[n].hash & mask_;
+        while (slots_[slot])
+          slot = (slot + 1) & mask_;
+        slots_[slot] = n + 1;
+      }
+    }
+    std::string arena_;
+    std::vector<Entry> entries_;
+    // 1 + the index in entries_ of the entry in each slot, or 0 if empty
+    std::vector<size_t> slots_;
+    size_t mask_;
+  };
+
+  /*! @class CpuSet
+   *  @brief A set of CPU (or NUMA node) numbers, parsed from the Linux
+   *  cpulist syntax used in sysfs and by taskset, e.g. 0-15,32-47 or
+   *  0-63:2/8 (the first 2 of every group of 8).
+   */
+  class CpuSet
+  {
+  public:
+    static const size_t max_cpus = 1 << 16;
+    // the set cpus, in increasing order
+    class const_iterator
+    {
+    public:
+      const_iterator(const CpuSet *set, size_t cpu) : set_(set), cpu_(cpu) {}
+      size_t operator*() const { return cpu_; }
+      const_iterator &operator++()
+      {
+        cpu_ = set_->next(cpu_ + 1);
+        return *this;
+      }
+      bool operator==(const const_iterator &other) const { return cpu_ == other.cpu_; }
+      bool operator!=(const const_iterator &other) const { return cpu_ != other.cpu_; }
+
+    private:
+      const CpuSet *set_;
+      size_t cpu_;
+    };
+    const_iterator begin() const { return const_iterator(this, next(0)); }
+    const_iterator end() const { return const_iterator(this, npos); }
+
+    void set(size_t cpu) { setBit(words_, cpu); }
+    void reset(size_t cpu) { clearBit(words_, cpu); }
+    bool test(size_t cpu) const { return testBit(words_, cpu); }
+    void clear() { std::fill(words_.begin(), words_.end(), 0); }
+    bool empty() const { return next(0) == npos; }
+    size_t count() const
+    {
+      size_t n = 0;
+      for (size_t w = 0; w < words_.size(); ++w)
+        n += popcount(words_[w]);
+      return n;
+    }
+    // the first set cpu not below cpu, or npos
+    size_t next(size_t cpu) const
+    {
+      for (size_t w = cpu / 64; w < words_.size(); ++w)
+      {
+        uint64_t word = w == cpu / 64 ? words_[w] & (~(uint64_t)0 << (cpu % 64)) : words_[w];
+        if (word == 0)
+          continue;
+#if defined(__GNUC__) || defined(__clang__)
+        return w * 64 + __builtin_ctzll(word);
+#else
+        size_t bit = 0;
+        while (!((word >> bit) & 1))
+          ++bit;
+        return w * 64 + bit;
+#endif
+      }
+      return npos;
+    }
+    // add the cpus of a cpulist to the set in a single pass over [p, end)
+    bool parse(const char *p, const char *end, std::string &error)
+    {
+      // like taskset, an empty list is an error rather than an empty set
+      if (p == end)
+      {
+        error = "expected a number";
+        return false;
+      }
+      while (p != end)
+      {
+        size_t first, last, used = 1, group = 1;
+        if (!number(p, end, first, error))
+          return false;
+        last = first;
+        if (p != end && *p == '-' && !number(++p, end, last, error))
+          return false;
+        if (p != end && *p == ':' && (!number(++p, end, used, error) || p == end || *p != '/' || !number(++p, end, group, error)))
+        {
+          if (error.empty())
+            error = "expected used/group after ':'";
+          return false;
+        }
+        if (last < first || used == 0 || group == 0 || used > group)
+        {
+          error = "invalid range";
+          return false;
+        }
+        for (size_t base = first; base <= last; base += group)
+          for (size_t cpu = base; cpu < base + used && cpu <= last; ++cpu)
+            set(cpu);
+        if (p != end && *p != ',')
+        {
+          error = "expected ','";
+          return false;
+        }
+        if (p != end && ++p == end)
+        {
+          error = "expected a number";
+          return false;
+        }
+      }
+      return true;
+    }
+    bool parse(const std::string &list, std::string &error) { return parse(list.data(), list.data() + list.size(), error); }
+    // the set as a cpulist
+    std::string str() const
+    {
+      std::ostringstream out;
+      for (size_t cpu = next(0); cpu != npos;)
+      {
+        size_t last = cpu;
+        while (test(last + 1))
+          ++last;
+        out << (out.tellp() > 0 ? "," : "") << cpu;
+        if (last > cpu)
+          out << "-" << last;
+        cpu = next(last + 1);
+      }
+      return out.str();
+    }
+    // add the cpulist held in a file such as /sys/devices/system/cpu/online
+    bool read(const char *path)
+    {
+#if defined(__linux__)
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0)
+        return false;
+      char buffer[4096];
+      ssize_t size = ::read(fd, buffer, sizeof(buffer));
+      ::close(fd);
+      while (size > 0 && isspace((unsigned char)buffer[size - 1]))
+        --size;
+      std::string error;
+      // an empty file, such as an empty offline list, is an empty set
+      return size == 0 || (size > 0 && parse(buffer, buffer + size, error));
+#else
+      (void)path;
+      return false;
+#endif
+    }
+#if defined(__linux__)
+    // copy into a cpu_set_t, failing if a cpu does not fit in CPU_SETSIZE
+    bool toCpuSet(cpu_set_t &out) const
+    {
+      CPU_ZERO(&out);
+      for (size_t cpu = next(0); cpu != npos; cpu = next(cpu + 1))
+      {
+        if (cpu >= CPU_SETSIZE)
+          return false;
+        CPU_SET(cpu, &out);
+      }
+      return true;
+    }
+#endif
+
+  private:
+    static bool number(const char *&p, const char *end, size_t &out, std::string &error)
+    {
+      if (p == end || *p < '0' || *p > '9')
+      {
+        error = "expected a number";
+        return false;
+      }
+      for (out = 0; p != end && *p >= '0' && *p <= '9'; ++p)
+      {
+        out = out * 10 + (*p - '0');
+        if (out >= max_cpus)
+        {
+          error = "cpu number out of range";
+          return false;
+        }
+      }
+      return true;
+    }
+    Bitset words_;
+  };
+
+  ArgumentParser() : ignore_first_(true), use_exceptions_(false), required_(0), parent_size_(0), trie_dirty_(true), frozen_(false), help_size_(0) {}
+  // --------------------------------------------------------------------------
+  // addArgument
+  // --------------------------------------------------------------------------
+  void appName(const std::string &name) { app_name_ = name; }
+  // include the arguments of a frozen parser, e.g. options shared by many
+  // tools, by reference. The parent must outlive this parser and must not
+  // change. Its constraints, derived defaults and sinks are not inherited
+  void addParent(const ArgumentParser &parent)
+  {
+    if (!parent.frozen_)
+      argumentError("parent parsers must be frozen");
+    if (!parent.final_name_.empty())
+      argumentError("parent parsers cannot have a final argument");
+    if (!arguments_.empty())
+      argumentError("parents must be added before any argument");
+    Parent p = {&parent, parent_size_};
+    parents_.push_back(p);
+    parent_size_ += parent.argumentCount();
+    variables_.insert(variables_.end(), parent.variables_.begin(), parent.variables_.end());
+    required_ += parent.required_;
+    trie_dirty_ = true;
+    frozen_ = false;
+  }
+  void addArgument(const std::string &name, char nargs = 0,
+                   std::string _default = "", bool required = false, std::string help = "")
+  {
+    if (name.size() > 2)
+    {
+      Argument arg("", verify(name), required, nargs, _default);
+      insertArgument(arg, help);
+    }
+    else
+    {
+      Argument arg(verify(name), "", required, nargs, _default);
+      insertArgument(arg, help);
+    }
+  }
+  void addArgument(const std::string &short_name, const std::string &name, char nargs = 0,
+                   std::string _default = "", bool required = false, std::string help = "")
+  {
+    Argument arg(verify(short_name), verify(name), required, nargs, _default);
+    insertArgument(arg, help);
+  }
+  void addFinalArgument(const std::string &name, char nargs = 1, std::string _default = "", bool required = true, std::string help = "")
+  {
+    final_name_ = delimit(name);
+    Argument arg("", final_name_, required, nargs, _default);
+    insertArgument(arg, help);
+  }
+  // help given as a C string, such as a string literal, is borrowed rather
+  // than copied, so it must outlive the parser
+  void addArgument(const std::string &name, char nargs, std::string _default, bool required, const char *help)
+  {
+    addArgument(name, nargs, _default, required, std::string());
+    arguments_.back().help_ref = help;
+  }
+  void addArgument(const std::string &short_name, const std::string &name, char nargs, std::string _default, bool required, const char *help)
+  {
+    addArgument(short_name, name, nargs, _default, required, std::string());
+    arguments_.back().help_ref = help;
+  }
+  void addFinalArgument(const std::string &name, char nargs, std::string _default, bool required, const char *help)
+  {
+    addFinalArgument(name, nargs, _default, required, std::string());
+    arguments_.back().help_ref = help;
+  }
+  // register a table of arguments at once. All names are checked before any
+  // argument is added, and every invalid or duplicate name is reported in a
+  // single error
+  void addArguments(const ArgSpec *specs, size_t size)
+  {
+    std::string errors;
+    IndexMap names;
+    for (size_t n = 0; n < size; ++n)
+    {
+      const char *keys[2] = {specs[n].short_name, specs[n].name};
+      if (!(keys[0] && *keys[0]) && !(keys[1] && *keys[1]))
+        errors.append(errors.empty() ? "" : "; ").append("argument names must be non-empty");
+      for (size_t k = 0; k < 2; ++k)
+      {
+        if (!keys[k] || !*keys[k])
+          continue;
+        std::string key(keys[k]), error = nameError(key, k == 0);
+        if (error.empty() && (!names.insert(std::make_pair(key, n)).second || lookup(key) != npos))
+          error = std::string("duplicate argument '").append(key).append("'");
+        if (!error.empty())
+          errors.append(errors.empty() ? "" : "; ").append(error);
+      }
+    }
+    if (!errors.empty())
+      argumentError(errors);
+
+    arguments_.reserve(arguments_.size() + size);
+    variables_.reserve(variables_.size() + size);
+#if __cplusplus >= 201103L
+    index_.reserve(index_.size() + names.size());
+#endif
+    for (size_t n = 0; n < size; ++n)
+    {
+      const ArgSpec &spec = specs[n];
+      arguments_.push_back(Argument());
+      Argument &arg = arguments_.back();
+      arg.short_name.assign(spec.short_name ? spec.short_name : "");
+      arg.name.assign(spec.name ? spec.name : "");
+      arg.default_value.assign(spec.default_value ? spec.default_value : "");
+      arg.required = spec.required;
+      arg.setNargs(spec.nargs);
+      // the help is referenced in place, so registering it costs nothing
+      arg.help_ref = spec.help;
+      indexArgument("", 0);
+    }
+  }
+  void addArguments(const std::vector<ArgSpec> &specs) { addArguments(specs.empty() ? 0 : &specs[0], specs.size()); }
+  template <size_t N>
+  void addArguments(const ArgSpec (&specs)[N]) { addArguments(specs, N); }
+  void ignoreFirstArgument(bool ignore_first) { ignore_first_ = ignore_first; }
+  // bound the work and memory of parsing untrusted input. Exceeding a limit
+  // is a parse error
+  void setLimits(const Limits &limits) { limits_ = limits; }
+  const Limits &limits() const { return limits_; }
+
+  // --------------------------------------------------------------------------
+  // Constraints
+  // --------------------------------------------------------------------------
+  void addMutuallyExclusiveGroup(const std::vector<std::string> &names, bool required = false)
+  {
+    Constraint c = {Constraint::EXCLUSIVE, required, 0, Bitset()};
+    for (size_t n = 0; n < names.size(); ++n)
+      setBit(c.mask, argumentId(names[n]));
+    constraints_.push_back(c);
+  }
+  void addRequires(const std::string &name, const std::vector<std::string> &requires_names)
+  {
+    Constraint c = {Constraint::REQUIRES, false, argumentId(name), Bitset()};
+    for (size_t n = 0; n < requires_names.size(); ++n)
+      setBit(c.mask, argumentId(requires_names[n]));
+    constraints_.push_back(c);
+  }
+  void addConflicts(const std::string &name, const std::vector<std::string> &conflicts_names)
+  {
+    Constraint c = {Constraint::CONFLICTS, false, argumentId(name), Bitset()};
+    for (size_t n = 0; n < conflicts_names.size(); ++n)
+      setBit(c.mask, argumentId(conflicts_names[n]));
+    constraints_.push_back(c);
+  }
+
+  // --------------------------------------------------------------------------
+  // Derived defaults
+  // --------------------------------------------------------------------------
+  void addDerivedDefault(const std::string &name, const std::vector<std::string> &depends,
+                         std::function<std::string(ArgumentParser &)> fn)
+  {
+    size_t N = argumentId(name);
+    if (!argumentAt(N).fixed || argumentAt(N).fixed_nargs > 1 || argumentAt(N).store)
+      argumentError(std::string("derived default for ").append(name).append(" must take at most one untyped input"));
+    Derived d;
+    for (size_t n = 0; n < depends.size(); ++n)
+      d.depends.push_back(argumentId(depends[n]));
+    d.fn = fn;
+    derived_of_.resize(argumentCount(), size_t(npos));
+    derived_of_[N] = derived_.size();
+    derived_.push_back(d);
+    frozen_ = false;
+  }
+  // validate the schema once all arguments have been added. parse() freezes
+  // the schema itself if it has not been frozen already
+  void freeze()
+  {
+    derived_of_.resize(argumentCount(), size_t(npos));
+    std::vector<char> state(argumentCount(), 0);
+    std::vector<size_t> path;
+    for (size_t N = 0; N < argumentCount(); ++N)
+    {
+      if (!findCycle(N, state, path))
+        continue;
+      std::string msg("cyclic derived defaults: ");
+      for (size_t n = std::find(path.begin(), path.end(), path.back()) - path.begin(); n < path.size(); ++n)
+        msg.append(argumentAt(path[n]).canonicalName()).append(n + 1 < path.size() ? " -> " : "");
+      argumentError(msg);
+    }
+    packHelp();
+    frozen_ = true;
+  }
+  // --------------------------------------------------------------------------
+  // Path arguments
+  // --------------------------------------------------------------------------
+  // every input of the argument must satisfy checks, a combination of
+  // PathCheck flags. Violations are reported together at the end of parse()
+  void checkPaths(const std::string &name, unsigned checks) { mutableArgument(argumentId(name)).path_checks = checks; }
+  // the PathCheck flags each input of a path argument was found to satisfy
+  const std::vector<unsigned> &pathStatus(const std::string &name)
+  {
+    size_t N = argumentId(name);
+    if (N >= path_status_.size())
+      path_status_.resize(N + 1);
+    return path_status_[N];
+  }
+  // --------------------------------------------------------------------------
+  // Glob arguments
+  // --------------------------------------------------------------------------
+  // inputs containing wildcards are expanded by the parser, so patterns can
+  // be passed quoted instead of through the shell's argv
+  void expandGlobs(const std::string &name, unsigned options = GLOB_SORT | GLOB_UNIQUE)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (arg.fixed && arg.fixed_nargs <= 1)
+      argumentError(std::string("glob argument ").append(name).append(" must take more than one input"));
+    arg.glob = GLOB_EXPAND | options;
+  }
+  // hand every input of the argument to sink instead of storing it
+  void valueSink(const std::string &name, std::function<void(const std::string &)> sink)
+  {
+    size_t N = argumentId(name);
+    if (sinks_.size() <= N)
+      sinks_.resize(N + 1);
+    sinks_[N] = sink;
+  }
+  // --------------------------------------------------------------------------
+  // File arguments
+  // --------------------------------------------------------------------------
+  // the input of the argument names a file (optionally written @path) whose
+  // contents are only mapped when retrieveFile(name).data() is first called
+  void mapFiles(const std::string &name)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (!arg.fixed || arg.fixed_nargs != 1)
+      argumentError(std::string("file argument ").append(name).append(" must take exactly one input"));
+    arg.store = storeFile;
+    arg.reset = resetSlot<MappedFile>;
+    variables_[N] = MappedFile();
+  }
+  // convert the inputs of an argument to T as they are parsed. T may be a
+  // scalar (std::string, bool, an integer or floating point type) for
+  // arguments taking one input, a std::array or std::tuple of scalars with
+  // one element per input, or a std::vector of scalars. The argument is then
+  // retrieved as T
+  template <typename T>
+  void storeAs(const std::string &name)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (!Slot<T>::fits(arg))
+      argumentError(std::string("the type given to storeAs() does not match the number of inputs of ").append(name));
+    arg.store = Slot<T>::store;
+    arg.reset = Slot<T>::reset;
+    variables_[N] = T();
+  }
+  // store the key=value inputs of an argument, which may be repeated, in a
+  // FlatMap. policy decides what a repeated key does. The argument is then
+  // retrieved as a FlatMap
+  void storeAsMap(const std::string &name, DuplicatePolicy policy = DUPLICATE_LAST)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (arg.fixed && arg.fixed_nargs == 0)
+      argumentError(std::string("map argument ").append(name).append(" must take inputs"));
+    arg.duplicates = policy;
+    arg.store = storeMap;
+    arg.reset = resetMap;
+    variables_[N] = FlatMap();
+  }
+  // restrict the inputs of an argument to the names of choices, each mapped
+  // to a value of E, e.g. an enum. Inputs are resolved through a perfect hash
+  // of the names as they are parsed, and the argument is then retrieved as
+  // an E, or as a std::vector<E> if it takes several inputs
+  template <typename E>
+  void addChoices(const std::string &name, const std::vector<std::pair<std::string, E> > &choices)
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (arg.fixed && arg.fixed_nargs != 1)
+      argumentError(std::string("argument ").append(name).append(" with choices must take one input, or a variable number"));
+    if (choices.empty())
+      argumentError(std::string("argument ").append(name).append(" has no choices"));
+    std::shared_ptr<Choices> table(new Choices());
+    for (size_t n = 0; n < choices.size(); ++n)
+    {
+      if (std::find(table->names.begin(), table->names.end(), choices[n].first) != table->names.end())
+        argumentError(std::string("duplicate choice ").append(choices[n].first).append(" for ").append(name));
+      table->names.push_back(choices[n].first);
+      table->values.push_back(static_cast<long long>(choices[n].second));
+    }
+    table->build();
+    arg.choices = table;
+    arg.store = storeChoice<E>;
+    if (arg.fixed)
+    {
+      arg.reset = Slot<E>::reset;
+      variables_[N] = E();
+    }
+    else
+    {
+      arg.reset = Slot<std::vector<E> >::reset;
+      variables_[N] = std::vector<E>();
+    }
+  }
+  // require every input of an argument to consist of the characters of a
+  // class, given as the inside of a bracket expression, e.g. "A-Za-z0-9_-"
+  void checkChars(const std::string &name, const std::string &chars)
+  {
+    std::string pattern = std::string("[").append(chars).append("]"), error;
+    const char *p = pattern.c_str();
+    std::shared_ptr<Validator> validator = copyValidator(name);
+    validator->chars = ByteSet();
+    Pattern parser;
+    if (chars.empty() || !parser.parseClass(p, pattern.c_str() + pattern.size(), validator->chars, error) || *p)
+      argumentError(std::string("invalid character class [").append(chars).append("] for ").append(name).append(error.empty() ? "" : ": ").append(error));
+    validator->chars.findRuns();
+    validator->has_chars = true;
+    validator->chars_source = chars;
+    mutableArgument(argumentId(name)).validator = validator;
+  }
+  // require every input of an argument to match a regular expression, e.g.
+  // "[0-9a-f]{64}". The pattern is compiled once into a DFA
+  void checkPattern(const std::string &name, const std::string &pattern)
+  {
+    std::shared_ptr<Validator> validator = copyValidator(name);
+    std::string error;
+    if (!validator->pattern.compile(pattern, error))
+      argumentError(std::string("invalid pattern ").append(pattern).append(" for ").append(name).append(": ").append(error));
+    validator->has_pattern = true;
+    validator->pattern_source = pattern;
+    mutableArgument(argumentId(name)).validator = validator;
+  }
+  // parse the input of an argument as a size in bytes (4GiB, 64k, 1.5M),
+  // retrieved as a uint64_t, or as a duration (250ms, 1m30s), retrieved as
+  // std::chrono::nanoseconds. Inputs that overflow are rejected
+  void storeAsSize(const std::string &name) { storeUnits(name, storeSize, Slot<uint64_t>::reset, uint64_t()); }
+  void storeAsDuration(const std::string &name) { storeUnits(name, storeDuration, Slot<std::chrono::nanoseconds>::reset, std::chrono::nanoseconds()); }
+  // parse the inputs of an argument as a cpulist, or a list of NUMA nodes,
+  // into a CpuSet. Repeated inputs are merged, and on Linux every cpu or
+  // node must be online. The argument is then retrieved as a CpuSet
+  void storeAsCpuSet(const std::string &name) { storeCpuSet(name, storeCpus); }
+  void storeAsNodeSet(const std::string &name) { storeCpuSet(name, storeNodes); }
+  // split every input of an argument into a list of T separated by
+  // delimiter, e.g. --shards 0,8-15,32-63:2. Integer lists accept ranges of
+  // the form first-last and first-last:step. The argument is then retrieved
+  // as a std::vector<T>
+  template <typename T>
+  void storeAsList(const std::string &name, char delimiter = ',')
+  {
+    size_t N = argumentId(name);
+    Argument &arg = mutableArgument(N);
+    if (arg.fixed && arg.fixed_nargs == 0)
+      argumentError(std::string("list argument ").append(name).append(" must take inputs"));
+    arg.delimiter = delimiter;
+    arg.store = storeList<T>;
+    arg.reset = Slot<std::vector<T> >::reset;
+    variables_[N] = std::vector<T>();
+  }
+  std::string verify(const std::string &name)
+  {
+    std::string error = nameError(name, false);
+    if (!error.empty())
+      argumentError(error);
+    return name;
+  }
+  static std::string nameError(const std::string &name, bool short_only)
+  {
+    if (name.empty())
+      return "argument names must be non-empty";
+    if ((name.size() == 2 && name[0] != '-') || name.size() == 3)
+      return std::string("invalid argument '")
+          .append(name)
+          .append("'. Short names must begin with '-'");
+    if (short_only && name.size() > 2)
+      return std::string("invalid argument '")
+          .append(name)
+          .append("'. Short names must be a single character");
+    if (name.size() > 3 && (name[0] != '-' || name[1] != '-'))
+      return std::string("invalid argument '")
+          .append(name)
+          .append("'. Multi-character names must begin with '--'");
+    return "";
+  }
+
+  // --------------------------------------------------------------------------
+  // Parse
+  // --------------------------------------------------------------------------
+  void parse(size_t argc, const char **argv)
+  {
+    beginParse();
+    for (size_t n = 0; n < argc; ++n)
+      feed(argv[n]);
+    endParse();
+  }
+
+  void parse(const std::vector<std::string> &argv)
+  {
+    beginParse();
+    for (std::vector<std::string>::const_iterator in = argv.begin(); in != argv.end(); ++in)
+      feed(*in);
+    endParse();
+  }
+
+  // parse argv followed by the tokens read from a stream, separated by
+  // delimiter ('\n' or '\0' for find -print0). Empty tokens are skipped, and
+  // tokens are read through a fixed-size buffer as they are parsed
+  void parse(size_t argc, const char **argv, std::istream &in, char delimiter = '\n')
+  {
+    beginParse();
+    for (size_t n = 0; n < argc; ++n)
+      feed(argv[n]);
+    std::vector<char> &buffer = stream_buffer_;
+    buffer.resize(stream_buffer_size);
+    while (in)
+    {
+      in.read(&buffer[0], buffer.size());
+      feedChunk(&buffer[0], in.gcount(), delimiter);
+    }
+    if (in.bad())
+      argumentError("cannot read tokens from stream");
+    feedChunk(0, 0, delimiter);
+    endParse();
+  }
+  void parse(size_t argc, const char **argv, int fd, char delimiter = '\n')
+  {
+    beginParse();
+    for (size_t n = 0; n < argc; ++n)
+      feed(argv[n]);
+    std::vector<char> &buffer = stream_buffer_;
+    buffer.resize(stream_buffer_size);
+    for (;;)
+    {
+#if defined(_WIN32)
+      int got = _read(fd, &buffer[0], (unsigned)buffer.size());
+#else
+      ssize_t got = read(fd, &buffer[0], buffer.size());
+      if (got < 0 && errno == EINTR)
+        continue;
+#endif
+      if (got < 0)
+        argumentError("cannot read tokens from file descriptor");
+      if (got <= 0)
+        break;
+      feedChunk(&buffer[0], got, delimiter);
+    }
+    feedChunk(0, 0, delimiter);
+    endParse();
+  }
+  // as above, reading from the file at path, or from stdin if path is "-"
+  void parse(size_t argc, const char **argv, const std::string &path, char delimiter = '\n')
+  {
+    if (path == "-")
+      return parse(argc, argv, 0, delimiter);
+#if defined(_WIN32)
+    int fd = _open(path.c_str(), 0);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+#endif
+    if (fd < 0)
+      argumentError(std::string("cannot open ").append(path));
+    struct Closer
+    {
+      int fd;
+      ~Closer()
+      {
+#if defined(_WIN32)
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+      }
+    } closer = {fd};
+    parse(argc, argv, fd, delimiter);
+  }
+
+  // parse only the arguments that have been added. Unrecognized options and
+  // the inputs following them are left unparsed and returned, in order, as
+  // ranges of positions in argv
+  const std::vector<Range> &parseKnownArgs(size_t argc, const char **argv)
+  {
+    beginParse(true);
+    for (size_t n = 0; n < argc; ++n)
+      feed(argv[n]);
+    endParse();
+    return unknown_;
+  }
+  const std::vector<Range> &parseKnownArgs(const std::vector<std::string> &argv)
+  {
+    beginParse(true);
+    for (std::vector<std::string>::const_iterator in = argv.begin(); in != argv.end(); ++in)
+      feed(*in);
+    endParse();
+    return unknown_;
+  }
+
+  // second phase of a two-phase parse: once parseKnownArgs() has resolved the
+  // bootstrap arguments and more arguments have been added (e.g. by plugins
+  // it selected), parse only the tokens it left unrecognized. argv must be
+  // the one passed to parseKnownArgs()
+  void parsePending(size_t argc, const char **argv)
+  {
+    std::vector<Range> pending;
+    pending.swap(unknown_);
+    resumeParse();
+    // the pending tokens were counted against the limits when first fed
+    for (size_t n = 0; n < pending.size(); ++n)
+      for (size_t k = pending[n].first; k < pending[n].second && k < argc; ++k)
+        state_.bytes -= strlen(argv[k]);
+    for (size_t n = 0; n < pending.size(); ++n)
+    {
+      // the tokens of a range did not belong to the argument active before it
+      checkConsumed("");
+      state_.active = npos;
+      state_.unknown = false;
+      state_.position = pending[n].first;
+      for (size_t k = pending[n].first; k < pending[n].second && k < argc; ++k)
+        feed(argv[k]);
+    }
+    endParse();
+  }
+  void parsePending(const std::vector<std::string> &argv)
+  {
+    std::vector<const char *> pointers(argv.size());
+    for (size_t n = 0; n < argv.size(); ++n)
+      pointers[n] = argv[n].c_str();
+    parsePending(pointers.size(), pointers.empty() ? 0 : &pointers[0]);
+  }
+
+  // parse a single command string, split with shell quoting rules
+  void parseCommandLine(const std::string &line)
+  {
+    // the line is the upper bound of the tokens, so check it before splitting
+    if (limits_.max_bytes && line.size() > limits_.max_bytes)
+      argumentError(limitError("inputs too large", limits_.max_bytes));
+    // stop splitting one token past the limit, which feed() then reports
+    if (!tokenizer_.tokenize(line, limits_.max_tokens ? limits_.max_tokens + 1 : 0))
+      argumentError(std::string("unterminated quote or escape in ").append(line));
+    const std::vector<StringView> &tokens = tokenizer_.tokens();
+    beginParse();
+    for (size_t n = 0; n < tokens.size(); ++n)
+      feed(stream_token_.assign(tokens[n].data, tokens[n].size));
+    endParse();
+  }
+
+  // --------------------------------------------------------------------------
+  // Retrieve
+  // --------------------------------------------------------------------------
+  template <typename T>
+  const T retrieve(const std::string &name)
+  {
+    size_t N = lookup(delimit(name));
+    if (N == npos)
+      throw std::out_of_range("Key not found");
+    return retrieveAt<T>(N);
+  }
+  MappedFile &retrieveFile(const std::string &name)
+  {
+    size_t N = lookup(delimit(name));
+    if (N == npos)
+      throw std::out_of_range("Key not found");
+    if (countAt(N) == 0)
+      throw std::out_of_range("Value not found");
+    return variables_[N].castTo<MappedFile>();
+  }
+  // the map of a map argument, without copying it. It is valid until the
+  // next parse
+  const FlatMap &retrieveMap(const std::string &name)
+  {
+    size_t N = lookup(delimit(name));
+    if (N == npos)
+      throw std::out_of_range("Key not found");
+    if (countAt(N) == 0)
+      throw std::out_of_range("Value not found");
+    return variables_[N].castTo<FlatMap>();
+  }
+
+  // --------------------------------------------------------------------------
+  // Namespaces
+  // --------------------------------------------------------------------------
+  /*! @class Namespace
+   *  @brief A view over the arguments whose long names share a dotted
+   *  prefix, e.g. scope("db") covers --db.pool.size and --db.pool.timeout.
+   *
+   *  Names passed to a Namespace are relative to its prefix and are resolved
+   *  segment by segment through the parser's name trie. A Namespace is
+   *  invalidated when arguments are added to or cleared from its parser.
+   */
+  class Namespace
+  {
+  public:
+    Namespace() : parser_(0), node_(npos) {}
+    bool empty() const { return node_ == npos || parser_->trie_[node_].begin == parser_->trie_[node_].end; }
+    std::vector<std::string> names() const
+    {
+      std::vector<std::string> out;
+      if (node_ == npos)
+        return out;
+      const TrieNode &node = parser_->trie_[node_];
+      out.reserve(node.end - node.begin);
+      for (size_t n = node.begin; n < node.end; ++n)
+      {
+        const std::string &name = parser_->argumentAt(parser_->ns_order_[n]).name;
+        out.push_back(name.substr(std::min(name.size(), node.prefix_size)));
+      }
+      return out;
+    }
+    Namespace scope(const std::string &name) const { return Namespace(parser_, find(name)); }
+    bool exists(const std::string &name) const
+    {
+      size_t node = find(name);
+      return node != npos && parser_->trie_[node].argument != npos;
+    }
+    size_t count(const std::string &name) const { return exists(name) ? parser_->countAt(parser_->trie_[find(name)].argument) : 0; }
+    template <typename T>
+    const T retrieve(const std::string &name) const
+    {
+      size_t node = find(name);
+      if (node == npos || parser_->trie_[node].argument == npos)
+        throw std::out_of_range("Key not found");
+      return parser_->retrieveAt<T>(parser_->trie_[node].argument);
+    }
+
+  private:
+    friend class ArgumentParser;
+    Namespace(ArgumentParser *parser, size_t node) : parser_(parser), node_(node) {}
+    size_t find(const std::string &name) const { return node_ == npos ? npos : parser_->findNode(node_, name); }
+    ArgumentParser *parser_;
+    size_t node_;
+  };
+  Namespace scope(const std::string &prefix)
+  {
+    buildTrie();
+    return Namespace(this, findNode(0, prefix));
+  }
+
+  // --------------------------------------------------------------------------
+  // Results
+  // --------------------------------------------------------------------------
+  /*! @class Result
+   *  @brief A compact copy of the outcome of a parse, for holding many parses
+   *  at once.
+   *
+   *  Only the arguments set by the command line (or by a derived default) are
+   *  stored, as a sorted id array over a single arena of packed inputs. Every
+   *  other argument reads its default from the parser, which must outlive
+   *  the Result and must not be changed while it is in use.
+   */
+  class Result
+  {
+  public:
+    Result() : parser_(0) {}
+    void clear()
+    {
+      parser_ = 0;
+      ids_.clear();
+      slots_.clear();
+      ends_.clear();
+      arena_.clear();
+      typed_.clear();
+    }
+    // the number of arguments that were set
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+    bool exists(const std::string &name) const { return parser_ && parser_->lookup(delimit(name)) != npos; }
+    size_t count(const std::string &name) const
+    {
+      size_t N = parser_ ? parser_->lookup(delimit(name)) : npos;
+      return N == npos ? 0 : countAt(N, find(N));
+    }
+    template <typename T>
+    const T retrieve(const std::string &name) const
+    {
+      size_t N = parser_ ? parser_->lookup(delimit(name)) : npos;
+      if (N == npos)
+        throw std::out_of_range("Key not found");
+      size_t k = find(N);
+      if (countAt(N, k) == 0)
+        throw std::out_of_range("Value not found");
+      const Argument &arg = parser_->argumentAt(N);
+      if (arg.store)
+        return typedAt(N).retrieve<T>();
+      if (arg.fixed && arg.fixed_nargs <= 1)
+      {
+        Any value = k == npos ? arg.default_value : valueAt(slots_[k]);
+        return value.retrieve<T>();
+      }
+      std::vector<std::string> values;
+      values.reserve(slots_[k + 1] - slots_[k]);
+      for (size_t v = slots_[k]; v < slots_[k + 1]; ++v)
+        values.push_back(valueAt(v));
+      Any value = values;
+      return value.retrieve<T>();
+    }
+
+  private:
+    friend class ArgumentParser;
+    size_t find(size_t N) const
+    {
+      std::vector<uint32_t>::const_iterator it = std::lower_bound(ids_.begin(), ids_.end(), (uint32_t)N);
+      return it != ids_.end() && *it == N ? it - ids_.begin() : npos;
+    }
+    size_t countAt(size_t N, size_t k) const
+    {
+      const Argument &arg = parser_->argumentAt(N);
+      if (arg.store)
+        return k != npos || !arg.default_value.empty();
+      if (!arg.fixed || arg.fixed_nargs > 1)
+        return k == npos ? 0 : slots_[k + 1] - slots_[k];
+      else if (arg.fixed_nargs > 0)
+        return k == npos ? !arg.default_value.empty() : slots_[k + 1] > slots_[k] && !valueAt(slots_[k]).empty();
+      else
+        return 1;
+    }
+    std::string valueAt(size_t v) const
+    {
+      size_t begin = v == 0 ? 0 : ends_[v - 1];
+      return arena_.substr(begin, ends_[v] - begin);
+    }
+    Any &typedAt(size_t N) const
+    {
+      std::vector<std::pair<uint32_t, Any> >::iterator it =
+          std::lower_bound(typed_.begin(), typed_.end(), std::make_pair((uint32_t)N, Any()), TypedOrder());
+      return it->second;
+    }
+    struct TypedOrder
+    {
+      bool operator()(const std::pair<uint32_t, Any> &a, const std::pair<uint32_t, Any> &b) const { return a.first < b.first; }
+    };
+    void pushValue(const std::string &value)
+    {
+      arena_.append(value);
+      ends_.push_back(arena_.size());
+    }
+    // the inputs of ids_[k] are the values [slots_[k], slots_[k + 1]), and
+    // value v spans [ends_[v - 1], ends_[v]) of arena_. Arguments with typed
+    // storage keep their converted value, or converted default, in typed_
+    // instead
+    const ArgumentParser *parser_;
+    std::vector<uint32_t> ids_;
+    std::vector<uint32_t> slots_;
+    std::vector<uint32_t> ends_;
+    std::string arena_;
+    mutable std::vector<std::pair<uint32_t, Any> > typed_;
+  };
+  // copy the outcome of the last parse into out, reusing its storage
+  void result(Result &out)
+  {
+    out.clear();
+    out.parser_ = this;
+    out.slots_.push_back(0);
+    for (size_t N = 0; N < argumentCount(); ++N)
+    {
+      derive(N);
+      const Argument &arg = argumentAt(N);
+      if (arg.store)
+      {
+        // an unset argument keeps its default, as the parser converted it
+        if (testBit(seen_, N) || !arg.default_value.empty())
+          out.typed_.push_back(std::make_pair((uint32_t)N, variables_[N]));
+        if (!testBit(seen_, N))
+          continue;
+      }
+      else if (arg.fixed && arg.fixed_nargs <= 1)
+      {
+        const std::string &value = variables_[N].castTo<std::string>();
+        if (value == arg.default_value)
+          continue;
+        out.pushValue(value);
+      }
+      else
+      {
+        const std::vector<std::string> &values = variables_[N].castTo<std::vector<std::string>>();
+        if (values.empty())
+          continue;
+        for (size_t n = 0; n < values.size(); ++n)
+          out.pushValue(values[n]);
+      }
+      out.ids_.push_back(N);
+      out.slots_.push_back(out.ends_.size());
+    }
+  }
+  Result result()
+  {
+    Result out;
+    result(out);
+    return out;
+  }
+
+  /*! @class PooledResult
+   *  @brief A Result borrowed from a free list of the calling thread and
+   *  returned to it on destruction.
+   *
+   *  A returned Result keeps the capacity of its buffers, so once the pool
+   *  is warm, filling a PooledResult with result() does not allocate unless
+   *  the command line is larger than any seen before or sets arguments with
+   *  typed storage. Each thread keeps at most max_free Results.
+   */
+  class PooledResult
+  {
+  public:
+    static const size_t max_free = 64;
+    PooledResult() : result_(acquire()) {}
+    ~PooledResult() { release(result_); }
+    Result &operator*() const { return *result_; }
+    Result *operator->() const { return result_; }
+
+  private:
+    PooledResult(const PooledResult &);
+    PooledResult &operator=(const PooledResult &);
+    struct FreeList
+    {
+      ~FreeList()
+      {
+        for (size_t n = 0; n < results.size(); ++n)
+          delete results[n];
+      }
+      std::vector<Result *> results;
+    };
+    static FreeList &freeList()
+    {
+      static thread_local FreeList list;
+      return list;
+    }
+    static Result *acquire()
+    {
+      std::vector<Result *> &results = freeList().results;
+      if (results.empty())
+        return new Result();
+      Result *result = results.back();
+      results.pop_back();
+      return result;
+    }
+    static void release(Result *result)
+    {
+      std::vector<Result *> &results = freeList().results;
+      if (results.size() >= max_free)
+      {
+        delete result;
+        return;
+      }
+      result->clear();
+      results.reserve(max_free);
+      results.push_back(result);
+    }
+    Result *result_;
+  };
+
+  // --------------------------------------------------------------------------
   // Properties
   // --------------------------------------------------------------------------
   std::string usage()
@@ -451,9 +4152,9 @@ public:
     size_t linelength = 0;
 
     // get the required arguments
-    for (std::vector<Argument>::const_iterator it = arguments_.begin(); it != arguments_.end(); ++it)
+    for (size_t N = 0; N < argumentCount(); ++N)
     {
-      Argument arg = *it;
+      const Argument &arg = argumentAt(N);
       if (!arg.required)
         continue;
       if (arg.name.compare(final_name_) == 0)
@@ -474,9 +4175,9 @@ public:
     }
 
     // get the required arguments
-    for (std::vector<Argument>::const_iterator it = arguments_.begin(); it != arguments_.end(); ++it)
+    for (size_t N = 0; N < argumentCount(); ++N)
     {
-      Argument arg = *it;
+      const Argument &arg = argumentAt(N);
       if (arg.required)
         continue;
       if (arg.name.compare(final_name_) == 0)
@@ -497,9 +4198,9 @@ public:
     }
 
     // get the final argument
-    if (!final_name_.empty())
+    if (finalId() != npos)
     {
-      Argument arg = arguments_[index_[final_name_]];
+      const Argument &arg = argumentAt(finalId());
       std::string argstr = arg.toString(false);
       if (argstr.size() + linelength > 80)
       {
@@ -516,32 +4217,63 @@ public:
 
     return help.str();
   }
+  std::string help()
+  {
+    std::vector<std::string> texts;
+    collectHelp(texts);
+    std::ostringstream help;
+    help << usage() << "\n";
+    for (size_t N = 0; N < argumentCount(); ++N)
+    {
+      const Argument *it = &argumentAt(N);
+      std::string names = it->name == final_name_ ? upper(strip(it->name)) : it->short_name;
+      if (it->name != final_name_)
+        names.append(it->short_name.empty() || it->name.empty() ? "" : ", ").append(it->name);
+      help << "\n  " << names;
+      if (texts[N].empty())
+        continue;
+      if (names.size() + 2 > 22)
+        help << "\n" << std::string(24, ' ');
+      else
+        help << std::string(22 - names.size(), ' ');
+      help << texts[N];
+    }
+    return help.str();
+  }
   void useExceptions(bool state) { use_exceptions_ = state; }
-  bool empty() const { return index_.empty(); }
+  bool empty() const { return index_.empty() && parents_.empty(); }
   void clear()
   {
     ignore_first_ = true;
     required_ = 0;
+    final_name_.clear();
     index_.clear();
     arguments_.clear();
+    parents_.clear();
+    parent_size_ = 0;
     variables_.clear();
+    cache_.clear();
+    cached_.clear();
+    constraints_.clear();
+    sinks_.clear();
+    derived_.clear();
+    derived_of_.clear();
+    derived_done_.clear();
+    help_pending_.clear();
+    help_packed_.clear();
+    help_chunks_.clear();
+    help_size_ = 0;
+    trie_dirty_ = true;
+    frozen_ = false;
   }
-  bool exists(const std::string &name) const { return index_.count(delimit(name)) > 0; }
+  bool exists(const std::string &name) const { return lookup(delimit(name)) != npos; }
   size_t count(const std::string &name)
   {
     // check if the name is an argument
-    if (index_.count(delimit(name)) == 0)
+    size_t N = lookup(delimit(name));
+    if (N == npos)
       return 0;
-    size_t N = index_[delimit(name)];
-    Argument arg = arguments_[N];
-    Any var = variables_[N];
-    // check if the argument is a vector
-    if (!arg.fixed)
-      return var.castTo<std::vector<std::string>>().size();
-    else if (arg.fixed_nargs > 0)
-      return !var.castTo<std::string>().empty();
-    else
-      return 1;
+    return countAt(N);
   }
 };
 #endif
\ No newline at end of file
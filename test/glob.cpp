@@ -0,0 +1,120 @@
+// expandGlobs(): the matches of patterns against a temporary tree
+#include "test.hpp"
+#include <cstdlib>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string root;
+
+static void makeDir(const std::string &path) { mkdir((root + path).c_str(), 0755); }
+static void makeFile(const std::string &path) { close(open((root + path).c_str(), O_CREAT | O_WRONLY, 0644)); }
+
+static std::string join(const std::vector<std::string> &paths)
+{
+  std::string out;
+  for (size_t n = 0; n < paths.size(); ++n)
+    out.append(n ? " " : "").append(paths[n].compare(0, root.size(), root) == 0 ? paths[n].substr(root.size()) : paths[n]);
+  return out;
+}
+
+// the expansion of the patterns, relative to the root, or the error
+static std::string expand(const std::vector<std::string> &patterns, unsigned options = ArgumentParser::GLOB_SORT | ArgumentParser::GLOB_UNIQUE,
+                          size_t max_values = 0)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--inputs", '+');
+  parser.expandGlobs("inputs", options);
+  ArgumentParser::Limits limits = parser.limits();
+  limits.max_values = max_values;
+  parser.setLimits(limits);
+  std::vector<std::string> argv(1, "test");
+  argv.push_back("--inputs");
+  for (size_t n = 0; n < patterns.size(); ++n)
+    argv.push_back(patterns[n].compare(0, 1, "/") == 0 ? patterns[n] : root + patterns[n]);
+  std::string error = parseError(parser, argv);
+  if (!error.empty())
+    return error;
+  std::vector<std::string> inputs = parser.retrieve<std::vector<std::string> >("inputs");
+  if (!(options & ArgumentParser::GLOB_SORT))
+    std::sort(inputs.begin(), inputs.end());
+  return join(inputs);
+}
+
+static std::string expand(const std::string &pattern) { return expand(std::vector<std::string>(1, pattern)); }
+
+int main()
+{
+  char dir[] = "/tmp/argparse_glob_XXXXXX";
+  if (!mkdtemp(dir))
+    return 1;
+  root = std::string(dir) + "/";
+  makeDir("a");
+  makeDir("a/b");
+  makeDir("c");
+  makeDir(".hidden");
+  makeFile("x.parquet");
+  makeFile("a/x.parquet");
+  makeFile("a/y.txt");
+  makeFile("a/b/x.parquet");
+  makeFile("c/x.parquet");
+  makeFile(".hidden/x.parquet");
+  makeFile(".profile");
+  // a cycle that "**" must not follow
+  CHECK(symlink("..", (root + "a/up").c_str()) == 0);
+
+  CHECK_EQ(expand("*.parquet"), "x.parquet");
+  CHECK_EQ(expand("*/x.parquet"), "a/x.parquet c/x.parquet");
+  CHECK_EQ(expand("a/?.*"), "a/x.parquet a/y.txt");
+  CHECK_EQ(expand("[ab]/*.txt"), "a/y.txt");
+  CHECK_EQ(expand("**/x.parquet"), "a/b/x.parquet a/x.parquet c/x.parquet x.parquet");
+  CHECK_EQ(expand("a/**/*.parquet"), "a/b/x.parquet a/x.parquet");
+  // a trailing "**" matches the directory itself and files as well as
+  // directories below it, never the hidden ones, and never follows the link
+  CHECK_EQ(expand("a/**"), "a a/b a/b/x.parquet a/up a/x.parquet a/y.txt");
+  // an explicit leading dot matches hidden entries, but never . or ..
+  CHECK_EQ(expand(".*"), ".hidden .profile");
+  CHECK_EQ(expand("*"), "a c x.parquet");
+  // following a link by name is fine
+  CHECK_EQ(expand("a/up/c/*"), "a/up/c/x.parquet");
+
+  // a pattern that matches nothing is kept as is
+  CHECK_EQ(expand("*.csv"), "*.csv");
+  CHECK_EQ(expand("missing/**/x"), "missing/**/x");
+
+  // duplicates across patterns are dropped unless asked for
+  std::vector<std::string> twice;
+  twice.push_back("*/x.parquet");
+  twice.push_back("a/*.parquet");
+  CHECK_EQ(expand(twice), "a/x.parquet c/x.parquet");
+  CHECK_EQ(expand(twice, ArgumentParser::GLOB_SORT), "a/x.parquet c/x.parquet a/x.parquet");
+  // unsorted matches are streamed in any order
+  CHECK_EQ(expand(std::vector<std::string>(1, "**/x.parquet"), 0), "a/b/x.parquet a/x.parquet c/x.parquet x.parquet");
+
+  // the limits stop the walk, with or without sorting
+  CHECK(expand(std::vector<std::string>(1, "**/x.parquet"), ArgumentParser::GLOB_SORT, 3).find("too many inputs") != std::string::npos);
+  CHECK(expand(std::vector<std::string>(1, "**/x.parquet"), 0, 3).find("too many inputs") != std::string::npos);
+  CHECK_EQ(expand(std::vector<std::string>(1, "**/x.parquet"), ArgumentParser::GLOB_SORT, 4), "a/b/x.parquet a/x.parquet c/x.parquet x.parquet");
+
+  // a bare "**" relative to the working directory has no empty root
+  char cwd[4096];
+  if (getcwd(cwd, sizeof(cwd)) && chdir(dir) == 0)
+  {
+    ArgumentParser parser;
+    parser.useExceptions(true);
+    parser.addArgument("--inputs", '+');
+    parser.expandGlobs("inputs");
+    std::vector<std::string> argv(1, "test");
+    argv.push_back("--inputs");
+    argv.push_back("**");
+    CHECK_EQ(parseError(parser, argv), "");
+    CHECK_EQ(join(parser.retrieve<std::vector<std::string> >("inputs")), "a a/b a/b/x.parquet a/up a/x.parquet a/y.txt c c/x.parquet x.parquet");
+    CHECK(chdir(cwd) == 0);
+  }
+
+  std::string command = "rm -rf " + std::string(dir);
+  CHECK(system(command.c_str()) == 0);
+  return failures;
+}
@@ -0,0 +1,104 @@
+// help(): help text survives compression at freeze(), across several frozen
+// chunks and parent parsers, and C string help is borrowed
+#include "test.hpp"
+#include <cstdlib>
+
+static std::string name(size_t n)
+{
+  std::ostringstream out;
+  out << "--option" << n;
+  return out.str();
+}
+
+// texts that exercise literal runs, short and long matches, matches that
+// overlap their output, offsets near the 64 KiB window, and no text at all
+static std::vector<std::string> texts()
+{
+  std::vector<std::string> out;
+  out.push_back("output file");
+  out.push_back("");
+  out.push_back("the number of worker threads, or 0 to use one per online cpu");
+  out.push_back("the number of worker threads, or 0 to use one per online cpu");
+  out.push_back(std::string(1000, '='));
+  out.push_back("abcabcabcabcabcabcabcabcabcabcabcabcabcabcabc");
+  std::string noise;
+  srand(74);
+  for (size_t n = 0; n < 300; ++n)
+    noise += (char)(' ' + rand() % 95);
+  out.push_back(noise);
+  std::string filler;
+  for (size_t n = 0; filler.size() < 70000; ++n)
+    filler.append(name(n)).append(" ");
+  out.push_back(filler);
+  out.push_back("output file, again");
+  out.push_back(noise.substr(0, 17));
+  return out;
+}
+
+// the help printed for each argument, in order
+static bool helpHas(const std::string &help, const std::vector<std::string> &expected, size_t first)
+{
+  size_t pos = 0;
+  for (size_t n = 0; n < expected.size(); ++n)
+  {
+    pos = help.find("\n  " + name(first + n), pos);
+    if (pos == std::string::npos)
+      return false;
+    if (!expected[n].empty() && help.compare(help.find_first_not_of(' ', help.find(' ', pos + 3)), expected[n].size(), expected[n]) != 0)
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  const std::vector<std::string> expected = texts();
+
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  for (size_t n = 0; n < expected.size(); ++n)
+    parser.addArgument(name(n), 1, "", false, expected[n]);
+  std::string before = parser.help();
+  CHECK(helpHas(before, expected, 0));
+  parser.freeze();
+  CHECK_EQ(parser.help(), before);
+
+  // arguments added after freeze() are packed in a second chunk
+  for (size_t n = 0; n < expected.size(); ++n)
+    parser.addArgument(name(expected.size() + n), 1, "", false, expected[expected.size() - 1 - n]);
+  std::vector<std::string> reversed(expected.rbegin(), expected.rend());
+  parser.freeze();
+  CHECK(helpHas(parser.help(), expected, 0));
+  CHECK(helpHas(parser.help(), reversed, expected.size()));
+
+  // the help of a parent is read from the parent
+  ArgumentParser child;
+  child.useExceptions(true);
+  child.addParent(parser);
+  child.addArgument("--own", 1, "", false, std::string("the child's own option"));
+  child.freeze();
+  CHECK(helpHas(child.help(), expected, 0));
+  CHECK(child.help().find("--own                 the child's own option") != std::string::npos);
+
+  // help given as a C string is borrowed, not copied
+  char borrowed[] = "verbose output";
+  ArgumentParser table;
+  table.addArgument("-v", "--verbose", 0, "", false, borrowed);
+  table.addArgument("--quiet", 0, "", false, "no output");
+  ArgumentParser::ArgSpec specs[] = {{"-j", "--jobs", 1, "", false, "parallel jobs"}};
+  table.addArguments(specs);
+  table.freeze();
+  CHECK(table.help().find("-v, --verbose         verbose output") != std::string::npos);
+  CHECK(table.help().find("--quiet               no output") != std::string::npos);
+  CHECK(table.help().find("-j, --jobs            parallel jobs") != std::string::npos);
+  borrowed[0] = 'V';
+  CHECK(table.help().find("Verbose output") != std::string::npos);
+
+  // clear() drops the packed help with the arguments
+  parser.clear();
+  parser.addArgument("--fresh", 0, "", false, std::string("fresh help"));
+  parser.freeze();
+  CHECK(parser.help().find("fresh help") != std::string::npos);
+  CHECK(parser.help().find("output file") == std::string::npos);
+  return failures;
+}
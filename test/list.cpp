@@ -0,0 +1,96 @@
+// storeAsList(): items, ranges, overflow and the range cap
+#include "test.hpp"
+#include <stdint.h>
+
+// parse the input as a list of T, returning the items joined by spaces, or
+// "error: " and the message
+template <typename T>
+static std::string list(const std::string &input, size_t max_values = 0, char delimiter = ',')
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--items", 1);
+  parser.storeAsList<T>("items", delimiter);
+  ArgumentParser::Limits limits = parser.limits();
+  limits.max_values = max_values;
+  parser.setLimits(limits);
+  std::vector<std::string> argv(1, "test");
+  argv.push_back("--items");
+  argv.push_back(input);
+  std::string error = parseError(parser, argv);
+  if (!error.empty())
+    return "error: " + error;
+  std::vector<T> items = parser.retrieve<std::vector<T> >("items");
+  std::ostringstream out;
+  for (size_t n = 0; n < items.size(); ++n)
+    out << (n ? " " : "") << items[n];
+  return out.str();
+}
+
+static bool fails(const std::string &result, const std::string &message)
+{
+  return result.compare(0, 7, "error: ") == 0 && result.find(message) != std::string::npos;
+}
+
+int main()
+{
+  // items and ranges
+  CHECK_EQ(list<int>("1,2,3"), "1 2 3");
+  CHECK_EQ(list<unsigned>("0-6:2,64,100-102"), "0 2 4 6 64 100 101 102");
+  CHECK_EQ(list<int>("-5--1"), "-5 -4 -3 -2 -1");
+  CHECK_EQ(list<int>("-3-3:3"), "-3 0 3");
+  CHECK_EQ(list<int>("7-7"), "7");
+  CHECK_EQ(list<int>("1-10:4"), "1 5 9");
+  CHECK_EQ(list<int>("1;3-4", 0, ';'), "1 3 4");
+  CHECK_EQ(list<std::string>("a-b,c"), "a-b c");
+  CHECK_EQ(list<double>("1.5,-2,3e2"), "1.5 -2 300");
+
+  // integers are base 10, without leading whitespace
+  CHECK_EQ(list<int>("010,08"), "10 8");
+  CHECK(fails(list<int>("0x10"), "expected an integer"));
+  CHECK(fails(list<int>(" 5"), "expected an integer"));
+  CHECK(fails(list<unsigned>("-1"), "expected a non-negative integer"));
+  CHECK(fails(list<int>("1,,2"), "expected an integer"));
+  CHECK(fails(list<int>("1,"), "expected an integer"));
+  CHECK(fails(list<double>("1-2"), "expected a number"));
+
+  // malformed ranges
+  CHECK(fails(list<int>("5-1"), "invalid range"));
+  CHECK(fails(list<int>("1-5:0"), "invalid range"));
+  CHECK(fails(list<int>("1-5:-1"), "invalid range"));
+  CHECK(fails(list<int>("1-"), "expected an integer"));
+  CHECK(fails(list<int>("1-5:"), "expected an integer"));
+
+  // bounds out of the range of the type
+  CHECK_EQ(list<short>("32766-32767"), "32766 32767");
+  CHECK(fails(list<short>("0-32768"), "out of range"));
+  CHECK(fails(list<unsigned>("4294967296"), "out of range"));
+  CHECK(fails(list<long long>("9223372036854775808"), "out of range"));
+  CHECK(fails(list<unsigned long long>("18446744073709551616"), "out of range"));
+  CHECK_EQ(list<long long>("9223372036854775806-9223372036854775807"), "9223372036854775806 9223372036854775807");
+  CHECK_EQ(list<long long>("-9223372036854775808--9223372036854775807"), "-9223372036854775808 -9223372036854775807");
+
+  // spans across the whole type neither overflow nor expand without a limit
+  CHECK(fails(list<long long>("-9223372036854775808-9223372036854775807"), "range of more than 65536 items"));
+  CHECK(fails(list<unsigned long long>("0-18446744073709551615"), "range of more than 65536 items"));
+  CHECK_EQ(list<int64_t>("-9223372036854775808-9223372036854775807:9223372036854775807"),
+           "-9223372036854775808 -1 9223372036854775806");
+  CHECK_EQ(list<unsigned long long>("0-18446744073709551615:9223372036854775808"), "0 9223372036854775808");
+
+  // the cap is 65536 items per range
+  CHECK(!fails(list<unsigned>("0-65535"), ""));
+  CHECK(fails(list<unsigned>("0-65536"), "range of more than 65536 items"));
+  CHECK(!fails(list<unsigned>("0-65535,0-65535"), ""));
+
+  // Limits::max_values bounds all items instead
+  CHECK_EQ(list<int>("0-9", 10), "0 1 2 3 4 5 6 7 8 9");
+  CHECK(fails(list<int>("0-10", 10), "too many items"));
+  CHECK(fails(list<int>("0-4,5-9,10", 10), "too many items"));
+  CHECK(fails(list<int>("1,2,3", 2), "too many items"));
+  CHECK(!fails(list<unsigned>("0-99999", 100000), ""));
+  CHECK(fails(list<unsigned>("0-100000", 100000), "too many items"));
+
+  // the error names the input and the argument
+  CHECK(fails(list<int>("1,x"), "--items"));
+  return failures;
+}
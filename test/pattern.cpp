@@ -0,0 +1,153 @@
+// checkPattern() and checkChars(): tables of inputs each pattern must accept
+// and reject
+#include "test.hpp"
+
+struct Case
+{
+  const char *pattern;
+  const char *input;
+  bool match;
+};
+
+static const Case cases[] = {
+    // literals and anchors, which are implied
+    {"abc", "abc", true},
+    {"abc", "ab", false},
+    {"abc", "abcd", false},
+    {"^abc$", "abc", true},
+    {"a\\$", "a$", true},
+    // dot and escapes
+    {"a.c", "abc", true},
+    {"a.c", "ac", false},
+    {"\\d+", "0123", true},
+    {"\\d+", "12a", false},
+    {"\\w+", "a_Z9", true},
+    {"\\w+", "a-b", false},
+    {"\\s", " ", true},
+    {"\\S+", "a b", false},
+    {"\\D", "5", false},
+    {"a\\.b", "a.b", true},
+    {"a\\.b", "axb", false},
+    // bracket classes
+    {"[0-9a-f]{4}", "beef", true},
+    {"[0-9a-f]{4}", "BEEF", false},
+    {"[^0-9]+", "abc", true},
+    {"[^0-9]+", "ab1", false},
+    {"[]a]+", "]a]", true},
+    {"[a-]+", "a-a", true},
+    {"[a-]+", "a+a", false},
+    {"[\\d_]+", "1_2", true},
+    // groups and alternation
+    {"(ab)+", "ababab", true},
+    {"(ab)+", "aba", false},
+    {"cat|dog", "dog", true},
+    {"cat|dog", "cow", false},
+    {"(a|b)*c", "abbac", true},
+    {"(a|b)*c", "", false},
+    {"x(|y)z", "xz", true},
+    {"x(|y)z", "xyz", true},
+    // quantifiers
+    {"a*", "", true},
+    {"a+", "", false},
+    {"colou?r", "color", true},
+    {"colou?r", "colouur", false},
+    {"a{3}", "aaa", true},
+    {"a{3}", "aa", false},
+    {"a{2,}", "aaaaa", true},
+    {"a{2,}", "a", false},
+    {"a{1,3}", "aaa", true},
+    {"a{1,3}", "aaaa", false},
+    {"(a{2}|b){2}", "aab", true},
+    {"(a{2}|b){2}", "ab", false},
+    // realistic inputs
+        {"v\\d+\\.\\d+(\\.\\d+)?", "v1.12.3", true},
+    {"v\\d+\\.\\d+(\\.\\d+)?", "v1.", false},
+    {"[a-z]+(-[a-z]+)*", "foo-bar-baz", true},
+    {"[a-z]+(-[a-z]+)*", "foo--bar", false},
+};
+
+static bool accepts(const std::string &pattern, const std::string &input)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--input", 1);
+  parser.checkPattern("input", pattern);
+  std::vector<std::string> argv;
+  argv.push_back("test");
+  argv.push_back("--input");
+  argv.push_back(input);
+  return parseError(parser, argv).empty();
+}
+
+static bool compiles(const std::string &pattern)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--input", 1);
+  try
+  {
+    parser.checkPattern("input", pattern);
+  }
+  catch (const std::invalid_argument &)
+  {
+    return false;
+  }
+  return true;
+}
+
+static bool charsAccept(const std::string &chars, const std::string &input)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--input", 1);
+  parser.checkChars("input", chars);
+  std::vector<std::string> argv;
+  argv.push_back("test");
+  argv.push_back("--input");
+  argv.push_back(input);
+  return parseError(parser, argv).empty();
+}
+
+int main()
+{
+  for (size_t n = 0; n < sizeof(cases) / sizeof(cases[0]); ++n)
+    if (accepts(cases[n].pattern, cases[n].input) != cases[n].match)
+    {
+      std::cerr << "pattern " << cases[n].pattern << " on \"" << cases[n].input << "\": expected "
+                << (cases[n].match ? "a match" : "no match") << std::endl;
+      ++failures;
+    }
+
+  CHECK(accepts("[0-9a-f]{64}", std::string(64, 'e')));
+  CHECK(!accepts("[0-9a-f]{64}", std::string(63, 'e')));
+
+  // malformed patterns are rejected when declared
+  CHECK(!compiles("(ab"));
+  CHECK(!compiles("ab)"));
+  CHECK(!compiles("[a-"));
+  CHECK(!compiles("a{3,1}"));
+  CHECK(!compiles("*a"));
+  CHECK(!compiles("a\\"));
+  CHECK(compiles("a{0}"));
+
+  // character classes, including inputs longer than one 16-byte block
+  CHECK(charsAccept("A-Za-z0-9_-", "Build_42-rc"));
+  CHECK(!charsAccept("A-Za-z0-9_-", "Build 42"));
+  CHECK(charsAccept("a-z", std::string(100, 'q')));
+  CHECK(!charsAccept("a-z", std::string(37, 'q') + "Q" + std::string(20, 'q')));
+  CHECK(!charsAccept("a-z", std::string(16, 'q') + "\xff"));
+  CHECK(charsAccept("^a", "bcd"));
+  CHECK(!charsAccept("^a", "bad"));
+
+  // the error names the input and the argument
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--key", 1);
+  parser.checkPattern("key", "[0-9]+");
+  std::vector<std::string> argv;
+  argv.push_back("test");
+  argv.push_back("--key");
+  argv.push_back("12x");
+  CHECK(parseError(parser, argv).find("invalid input 12x to --key") == 0);
+  return failures;
+}
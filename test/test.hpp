@@ -0,0 +1,48 @@
+#ifndef ARGPARSE_TEST_HPP_
+#define ARGPARSE_TEST_HPP_
+
+#include "../argparse.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// a minimal harness: each test program runs its checks from main() and
+// returns the number of failures, so that 0 means every check passed
+static int failures = 0;
+
+#define CHECK(cond)                                                                       \
+  do                                                                                      \
+  {                                                                                       \
+    if (!(cond))                                                                          \
+    {                                                                                     \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; \
+      ++failures;                                                                         \
+    }                                                                                     \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                                                        \
+  do                                                                                                          \
+  {                                                                                                           \
+    if (!((a) == (b)))                                                                                        \
+    {                                                                                                         \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #a " == " #b ": " << (a) << " != " << (b) \
+                << std::endl;                                                                                 \
+      ++failures;                                                                                             \
+    }                                                                                                         \
+  } while (0)
+
+// parse argv, returning the error message, or "" on success
+inline std::string parseError(ArgumentParser &parser, const std::vector<std::string> &argv)
+{
+  try
+  {
+    parser.parse(argv);
+  }
+  catch (const std::invalid_argument &e)
+  {
+    return e.what();
+  }
+  return "";
+}
+
+#endif
@@ -0,0 +1,128 @@
+// Tokenizer: POSIX shell quoting, views into the input, and parseCommandLine()
+#include "test.hpp"
+
+struct Case
+{
+  const char *line;
+  // each token in brackets, so that empty tokens show
+  const char *tokens;
+  bool ok;
+};
+
+static const Case cases[] = {
+    {"", "", true},
+    {"   \t\n ", "", true},
+    {"a", "[a]", true},
+    {"  a  b\tc\nd  ", "[a][b][c][d]", true},
+    // single quotes keep everything literally
+    {"'a b'", "[a b]", true},
+    {"'a\\nb'", "[a\\nb]", true},
+    {"'\"'", "[\"]", true},
+    {"''", "[]", true},
+    {"'' ''", "[][]", true},
+    // double quotes only unescape $ ` \" \\ and newline
+    {"\"a b\"", "[a b]", true},
+    {"\"a\\\"b\"", "[a\"b]", true},
+    {"\"a\\\\b\"", "[a\\b]", true},
+    {"\"\\$x \\`y\\`\"", "[$x `y`]", true},
+    {"\"a\\nb\"", "[a\\nb]", true},
+    {"\"a\\\nb\"", "[ab]", true},
+    {"\"'\"", "[']", true},
+    {"\"\"", "[]", true},
+    // backslashes outside of quotes escape any character
+    {"a\\ b", "[a b]", true},
+    {"\\'a\\'", "['a']", true},
+    {"\\\\", "[\\]", true},
+    {"a\\\nb", "[ab]", true},
+    {"\\n", "[n]", true},
+    // quoted parts join the rest of their token
+    {"--name='John Smith'", "[--name=John Smith]", true},
+    {"a'b'\"c\"d\\ e f", "[abcd e][f]", true},
+    {"x'' y", "[x][y]", true},
+    // unterminated quotes and trailing backslashes are errors
+    {"'a", "", false},
+    {"\"a", "", false},
+    {"\"a\\\"", "", false},
+    {"\"a\\", "", false},
+    {"a\\", "", false},
+    {"ok 'a", "", false},
+};
+
+static std::string show(ArgumentParser::Tokenizer &tokenizer)
+{
+  std::string out;
+  for (size_t n = 0; n < tokenizer.tokens().size(); ++n)
+    out.append("[").append(tokenizer.tokens()[n].str()).append("]");
+  return out;
+}
+
+int main()
+{
+  ArgumentParser::Tokenizer tokenizer;
+  for (size_t n = 0; n < sizeof(cases) / sizeof(cases[0]); ++n)
+  {
+    std::string line(cases[n].line);
+    bool ok = tokenizer.tokenize(line);
+    if (ok != cases[n].ok || (ok && show(tokenizer) != cases[n].tokens))
+    {
+      std::cerr << "tokenize(" << line << "): got " << (ok ? show(tokenizer) : "an error") << ", expected "
+                << (cases[n].ok ? cases[n].tokens : "an error") << std::endl;
+      ++failures;
+    }
+  }
+
+  // tokens longer than a 16-byte block, with the quote at either side of it
+  std::string longer(40, 'x');
+  std::string line = longer + " " + longer + "' '" + longer + " \"" + longer + "\"";
+  CHECK(tokenizer.tokenize(line));
+  CHECK_EQ(tokenizer.tokens().size(), 3u);
+  CHECK(tokenizer.tokens()[1] == longer + " " + longer);
+  CHECK(tokenizer.tokens()[2] == longer);
+
+  // plain tokens are views into the input, and the views of unescaped tokens
+  // stay put while later ones are unescaped
+  line = "plain 'one' \"two\" th\\ree " + std::string(100, 'z');
+  CHECK(tokenizer.tokenize(line));
+  CHECK_EQ(show(tokenizer), "[plain][one][two][three][" + std::string(100, 'z') + "]");
+  CHECK(tokenizer.tokens()[0].data == line.data());
+  CHECK(tokenizer.tokens()[4].data == line.data() + line.size() - 100);
+  CHECK(tokenizer.tokens()[1].data + 3 <= tokenizer.tokens()[2].data);
+
+  // at most max_tokens are split off, and the rest is not looked at
+  line = "a b c 'unterminated";
+  CHECK(tokenizer.tokenize(line, 2));
+  CHECK_EQ(show(tokenizer), "[a][b]");
+  CHECK(tokenizer.tokenize("a b", 3, 5));
+  CHECK_EQ(show(tokenizer), "[a][b]");
+
+  // after a pointer, the second argument is the size of the input
+  CHECK(tokenizer.tokenize("a b c", 3));
+  CHECK_EQ(show(tokenizer), "[a][b]");
+
+  // string literals tokenize without a copy
+  CHECK(tokenizer.tokenize("--x 'y z'"));
+  CHECK_EQ(show(tokenizer), "[--x][y z]");
+
+  // parseCommandLine() splits the line the same way
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("-n", "--name", 1);
+  parser.addArgument("--tags", '+');
+  parser.addFinalArgument("input");
+  parser.parseCommandLine("tool --name 'John Smith' --tags a\\ b \"c d\" -- in\\ file.txt");
+  CHECK_EQ(parser.retrieve<std::string>("name"), "John Smith");
+  CHECK_EQ(parser.retrieve<std::vector<std::string> >("tags").size(), 2u);
+  CHECK_EQ(parser.retrieve<std::vector<std::string> >("tags")[1], "c d");
+  CHECK_EQ(parser.retrieve<std::string>("input"), "in file.txt");
+  bool thrown = false;
+  try
+  {
+    parser.parseCommandLine("tool --name 'John");
+  }
+  catch (const std::invalid_argument &e)
+  {
+    thrown = std::string(e.what()).find("unterminated quote") != std::string::npos;
+  }
+  CHECK(thrown);
+  return failures;
+}
@@ -0,0 +1,143 @@
+// storeAsSize() and storeAsDuration(): units, fractions and overflow
+#include "test.hpp"
+#include <chrono>
+#include <stdint.h>
+
+// parse the input as a size, returning the number of bytes, or "error: " and
+// the message
+static std::string size(const std::string &input)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--size", 1);
+  parser.storeAsSize("size");
+  std::vector<std::string> argv(1, "test");
+  argv.push_back("--size");
+  argv.push_back(input);
+  std::string error = parseError(parser, argv);
+  if (!error.empty())
+    return "error: " + error;
+  std::ostringstream out;
+  out << parser.retrieve<uint64_t>("size");
+  return out.str();
+}
+
+// the same for a duration, in nanoseconds
+static std::string duration(const std::string &input)
+{
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--timeout", 1);
+  parser.storeAsDuration("timeout");
+  std::vector<std::string> argv(1, "test");
+  argv.push_back("--timeout");
+  argv.push_back(input);
+  std::string error = parseError(parser, argv);
+  if (!error.empty())
+    return "error: " + error;
+  std::ostringstream out;
+  out << parser.retrieve<std::chrono::nanoseconds>("timeout").count();
+  return out.str();
+}
+
+static bool fails(const std::string &result, const std::string &message)
+{
+  return result.compare(0, 7, "error: ") == 0 && result.find(message) != std::string::npos;
+}
+
+int main()
+{
+  // sizes
+  CHECK_EQ(size("0"), "0");
+  CHECK_EQ(size("512"), "512");
+  CHECK_EQ(size("512B"), "512");
+  CHECK_EQ(size("512k"), "512000");
+  CHECK_EQ(size("512K"), "512000");
+  CHECK_EQ(size("2MB"), "2000000");
+  CHECK_EQ(size("4GiB"), "4294967296");
+  CHECK_EQ(size("4Gi"), "4294967296");
+  CHECK_EQ(size("1.5M"), "1500000");
+  CHECK_EQ(size("1.5KiB"), "1536");
+  CHECK_EQ(size(".5K"), "500");
+  CHECK_EQ(size("1."), "1");
+  CHECK_EQ(size("0.000000000000000000001EB"), "0");
+
+  // sizes at the limit of uint64_t
+  CHECK_EQ(size("18446744073709551615"), "18446744073709551615");
+  CHECK_EQ(size("18446744073709551615B"), "18446744073709551615");
+  CHECK(fails(size("18446744073709551616"), "out of range"));
+  CHECK(fails(size("99999999999999999999999"), "out of range"));
+  CHECK_EQ(size("15EiB"), "17293822569102704640");
+  CHECK(!fails(size("15.99EiB"), ""));
+  CHECK(fails(size("16EiB"), "out of range"));
+  CHECK(fails(size("18.5EB"), "out of range"));
+  CHECK_EQ(size("18446744073709551615.5"), "18446744073709551615");
+  CHECK(fails(size("18446744073709551615k"), "out of range"));
+
+  // malformed sizes
+  CHECK(fails(size(""), "expected a number"));
+  CHECK(fails(size("."), "expected a number"));
+  CHECK(fails(size("k"), "expected a number"));
+  CHECK(fails(size("-1"), "expected a number"));
+  CHECK(fails(size(" 1"), "expected a number"));
+  CHECK(fails(size("5x"), "unknown unit"));
+  CHECK(fails(size("5 k"), "unknown unit"));
+  CHECK(fails(size("5kk"), "unknown unit"));
+  CHECK(fails(size("5ki"), "unknown unit"));
+
+  // durations
+  CHECK_EQ(duration("0"), "0");
+  CHECK_EQ(duration("0s"), "0");
+  CHECK_EQ(duration("250ms"), "250000000");
+  CHECK_EQ(duration("10us"), "10000");
+  CHECK_EQ(duration("10\xc2\xb5s"), "10000");
+  CHECK_EQ(duration("7ns"), "7");
+  CHECK_EQ(duration("1.5s"), "1500000000");
+  CHECK_EQ(duration("1m30s"), "90000000000");
+  CHECK_EQ(duration("1h30m"), "5400000000000");
+  CHECK_EQ(duration("1s500ms"), "1500000000");
+  CHECK_EQ(duration("1m1ms"), "60001000000");
+
+  // durations at the limit of std::chrono::nanoseconds
+  CHECK_EQ(duration("9223372036854775807ns"), "9223372036854775807");
+  CHECK(fails(duration("9223372036854775808ns"), "out of range"));
+  CHECK_EQ(duration("2562047h47m16.854775807s"), "9223372036854775807");
+  CHECK(fails(duration("2562047h47m16.854775808s"), "out of range"));
+  CHECK(fails(duration("2562048h"), "out of range"));
+  CHECK(fails(duration("2562047h48m"), "out of range"));
+  CHECK(fails(duration("5124094h"), "out of range"));
+  CHECK(fails(duration("18446744073709551615ns1ns"), "out of range"));
+  CHECK(fails(duration("99999999999999999999h"), "out of range"));
+
+  // malformed durations
+  CHECK(fails(duration(""), "expected a number"));
+  CHECK(fails(duration("5"), "unknown unit"));
+  CHECK(fails(duration("s"), "expected a number"));
+  CHECK(fails(duration("1sec"), "expected a number"));
+  CHECK(fails(duration("1s 2s"), "expected a number"));
+  CHECK(fails(duration("-1s"), "expected a number"));
+  CHECK(fails(duration("1d"), "unknown unit"));
+
+  // defaults are converted like inputs, and the argument must take one input
+  ArgumentParser parser;
+  parser.useExceptions(true);
+  parser.addArgument("--cache", 1, "64MiB");
+  parser.storeAsSize("cache");
+  parser.addArgument("--timeout", 1, "30s");
+  parser.storeAsDuration("timeout");
+  parser.addArgument("--sizes", '+');
+  bool thrown = false;
+  try
+  {
+    parser.storeAsSize("sizes");
+  }
+  catch (const std::invalid_argument &)
+  {
+    thrown = true;
+  }
+  CHECK(thrown);
+  CHECK_EQ(parseError(parser, std::vector<std::string>(1, "test")), "");
+  CHECK_EQ(parser.retrieve<uint64_t>("cache"), 64u << 20);
+  CHECK(parser.retrieve<std::chrono::nanoseconds>("timeout") == std::chrono::seconds(30));
+  return failures;
+}